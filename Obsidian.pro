@@ -21,7 +21,20 @@ SOURCES += src/main.cpp\
     src/tableview.cpp \
     src/listview.cpp \
     src/basedlg.cpp \
-    src/view.cpp
+    src/view.cpp \
+    src/executor.cpp \
+    src/resultmodel.cpp \
+    src/bookindex.cpp \
+    src/csvparser.cpp \
+    src/pagedmodel.cpp \
+    src/sortproxy.cpp \
+    src/columnsizer.cpp \
+    src/personindex.cpp \
+    src/migrator.cpp \
+    src/querystats.cpp \
+    src/tracer.cpp \
+    src/watchdog.cpp \
+    src/diagnosticsdlg.cpp
 
 HEADERS  += \
     src/deletedlg.h \
@@ -33,7 +46,20 @@ HEADERS  += \
     src/tableview.h \
     src/listview.h \
     src/basedlg.h \
-    src/view.h
+    src/view.h \
+    src/executor.h \
+    src/resultmodel.h \
+    src/bookindex.h \
+    src/csvparser.h \
+    src/pagedmodel.h \
+    src/sortproxy.h \
+    src/columnsizer.h \
+    src/personindex.h \
+    src/migrator.h \
+    src/querystats.h \
+    src/tracer.h \
+    src/watchdog.h \
+    src/diagnosticsdlg.h
 
 FORMS +=
 
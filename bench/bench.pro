@@ -0,0 +1,72 @@
+#-------------------------------------------------
+#
+# Benchmarks der zeitkritischen Pfade von Obsidian
+#
+#-------------------------------------------------
+
+QT       += core gui sql testlib
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = benchmark
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+DEFINES += OBSIDIAN_BENCHMARK
+INCLUDEPATH += ../src
+
+SOURCES += benchmark.cpp\
+    ../src/main.cpp \
+    ../src/deletedlg.cpp \
+    ../src/insertdlg.cpp \
+    ../src/selectdlg.cpp \
+    ../src/importdlg.cpp \
+    ../src/settingsdlg.cpp \
+    ../src/tableview.cpp \
+    ../src/listview.cpp \
+    ../src/basedlg.cpp \
+    ../src/view.cpp \
+    ../src/executor.cpp \
+    ../src/resultmodel.cpp \
+    ../src/bookindex.cpp \
+    ../src/csvparser.cpp \
+    ../src/pagedmodel.cpp \
+    ../src/sortproxy.cpp \
+    ../src/columnsizer.cpp \
+    ../src/personindex.cpp \
+    ../src/migrator.cpp \
+    ../src/querystats.cpp \
+    ../src/tracer.cpp \
+    ../src/watchdog.cpp \
+    ../src/diagnosticsdlg.cpp
+
+HEADERS  += \
+    ../src/deletedlg.h \
+    ../src/insertdlg.h \
+    ../src/main.h \
+    ../src/selectdlg.h \
+    ../src/importdlg.h \
+    ../src/settingsdlg.h \
+    ../src/tableview.h \
+    ../src/listview.h \
+    ../src/basedlg.h \
+    ../src/view.h \
+    ../src/executor.h \
+    ../src/resultmodel.h \
+    ../src/bookindex.h \
+    ../src/csvparser.h \
+    ../src/pagedmodel.h \
+    ../src/sortproxy.h \
+    ../src/columnsizer.h \
+    ../src/personindex.h \
+    ../src/migrator.h \
+    ../src/querystats.h \
+    ../src/tracer.h \
+    ../src/watchdog.h \
+    ../src/diagnosticsdlg.h
+
+CONFIG += c++11
+
+RESOURCES += \
+    ../src/Obsidian.qrc
@@ -0,0 +1,502 @@
+#include "main.h"
+#include "executor.h"
+#include "bookindex.h"
+#include "listview.h"
+#include "importdlg.h"
+#include "selectdlg.h"
+#include <QtTest>
+#include <QtSql>
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTextCodec>
+#include <QTabWidget>
+#include <QLineEdit>
+#include <QDateEdit>
+
+const int FIRST_GRADE = 5;                       ///< Unterste Jahrgangsstufe
+const int LAST_GRADE = 12;                       ///< Oberste Jahrgangsstufe
+const int LAST_LETTERED_GRADE = 10;              ///< Ab der nächsten Jgst. gibt es keine Klassenbuchstaben mehr
+const int FORMS_PER_GRADE = 5;                   ///< Klassen pro Jgst. (a-e)
+const int STUDENTS_PER_FORM = 30;                ///< Schüler pro Klasse
+const int BOOKS_PER_GRADE = 40;                  ///< Lehrbücher pro Jgst.
+const int ALIASES_PER_BOOK = 2;                  ///< Aliasse pro Buch
+
+/*!
+ * \brief Benchmarks der zeitkritischen Pfade (Listenansicht, Import, Suche, Buchauflösung)
+ *
+ * Ohne weitere Einstellung wird ein synthetischer Datenbestand in einer temporären SQLite-Datenbank angelegt.
+ * Ihre Tabellen entsprechen denen aus buecher.sql; nur der View `Buch` wird durch eine zusätzliche Spalte `titel`
+ * in `buch` ersetzt, weil SQLite bei Tabellen- und View-Namen nicht zwischen Groß- und Kleinschreibung
+ * unterscheidet. Mit OBSIDIAN_BENCH_DB=mysql wird stattdessen die in den Einstellungen eingetragene Datenbank
+ * benutzt, z.B. mit einem Bestand aus tools/gendata; sie wird nur gelesen, die Klasse der Listenansicht steht
+ * dann in OBSIDIAN_BENCH_FORM (Vorgabe 7a).
+ */
+class Benchmark : public QObject {
+	Q_OBJECT
+private:
+	QTemporaryDir a_dir;                     ///< Nimmt Datenbank und CSV-Dateien auf
+	QString a_form;                          ///< Klasse der Listenansicht
+	QString a_isbn;                          ///< Vorhandene ISBN für bookLookup()
+	QString a_alias;                         ///< Vorhandener Alias für bookLookup()
+	QScopedPointer<QueryStats> a_stats;      ///< Zeitmessung der Statements wie in der Anwendung
+	QScopedPointer<QueryExecutor> a_executor;///< Führt die Abfragen im Hintergrund aus
+	QScopedPointer<BookIndex> a_books;       ///< Verzeichnis der Bücher und Aliasse
+
+	bool m_openMysql();
+	bool m_createDatabase();
+	bool m_insert(QString sql, QList<QVariantList> columns);
+	bool m_writeCsv(QString fileName, int rows);
+	bool m_loadList(ListModel *model, bool data);
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void listHeader();
+	void listData();
+	void listCells();
+	void importCsv_data();
+	void importCsv();
+	void escapeString_data();
+	void escapeString();
+	void findFilter_data();
+	void findFilter();
+	void bookLookup_data();
+	void bookLookup();
+};
+
+/*!
+ * \brief Öffnet die in den Einstellungen eingetragene MySQL-Datenbank
+ * \return true - Verbindung geöffnet
+ */
+bool Benchmark::m_openMysql() {
+	load_settings();
+	QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL");
+	db.setPort(DB_PORT);
+	db.setHostName(DB_IP);
+	db.setDatabaseName(DB_NAME);
+	db.setUserName(DB_USER);
+	db.setPassword(DB_PASSWORD);
+	if (!db.open()) {
+		qWarning("%s", qPrintable(db.lastError().text()));
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * \brief Fügt viele Datensätze mit einem einzigen Batch ein
+ * \param sql INSERT-Statement mit ?-Platzhaltern
+ * \param columns Werte spaltenweise
+ * \return true - Erfolg
+ */
+bool Benchmark::m_insert(QString sql, QList<QVariantList> columns) {
+	QSqlQuery q;
+	q.prepare(sql);
+	foreach (const QVariantList &column, columns)
+		q.addBindValue(column);
+	if (!q.execBatch()) {
+		qWarning("%s: %s", qPrintable(sql), qPrintable(q.lastError().text()));
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * \brief Legt die SQLite-Datenbank mit dem synthetischen Datenbestand an
+ * \return true - Erfolg
+ *
+ * Jede Jgst. hat BOOKS_PER_GRADE Bücher mit je ALIASES_PER_BOOK Aliassen. Jeder Schüler hat etwa 90% der
+ * Bücher seiner Jgst. im Büchertausch, jeder vierte leiht außerdem ein Buch der Jgst. darunter. Die Verteilung
+ * ist fest, damit die Zahlen verschiedener Läufe vergleichbar bleiben.
+ */
+bool Benchmark::m_createDatabase() {
+	QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+	db.setDatabaseName(a_dir.path() + "/obsidian.sqlite");
+	if (!db.open()) {
+		qWarning("%s", qPrintable(db.lastError().text()));
+		return false;
+	}
+
+	QSqlQuery q;
+	QStringList schema = QStringList()
+		<< "CREATE TABLE `buch` (`isbn` BIGINT PRIMARY KEY, `name` VARCHAR(50) NOT NULL, `jgst` VARCHAR(10), "
+		   "`titel` VARCHAR(61))"
+		<< "CREATE TABLE `schueler` (`id` INTEGER PRIMARY KEY, `name` VARCHAR(50) NOT NULL, `vajahr` INT, "
+		   "`kbuchst` VARCHAR(3))"
+		<< "CREATE INDEX `klasse` ON `schueler` (`vajahr`, `kbuchst`)"
+		<< "CREATE TABLE `sausleihe` (`sid` INT NOT NULL, `bid` BIGINT NOT NULL, `anz` SMALLINT NOT NULL DEFAULT 1, "
+		   "`adatum` DATE, PRIMARY KEY (`sid`, `bid`))"
+		<< "CREATE TABLE `btausch` (`sid` INT NOT NULL, `bid` BIGINT NOT NULL, `datum` DATE, PRIMARY KEY (`sid`, `bid`))"
+		<< "CREATE TABLE `aliasse` (`alias` VARCHAR(13) PRIMARY KEY, `isbn` BIGINT NOT NULL)";
+	foreach (const QString &sql, schema)
+		if (!q.exec(sql)) {
+			qWarning("%s: %s", qPrintable(sql), qPrintable(q.lastError().text()));
+			return false;
+		}
+
+	static const char *subjects[] = {"Deutsch", "Englisch", "Mathematik", "Physik", "Chemie", "Biologie",
+					 "Geschichte", "Erdkunde", "Latein", "Religion"};
+	const int numSubjects = sizeof(subjects) / sizeof(*subjects);
+	QVariantList isbns, names, jgsts, titles, aliases, aliasIsbns;
+	for (int grade = FIRST_GRADE; grade <= LAST_GRADE; ++grade)
+		for (int b = 0; b < BOOKS_PER_GRADE; ++b) {
+			qlonglong isbn = 9783000000000LL + grade * 1000 + b;
+			QString name = QString("%1 %2").arg(subjects[b % numSubjects]).arg(QChar('A' + b / numSubjects));
+			isbns << isbn;
+			names << name;
+			jgsts << QString::number(grade);
+			titles << QString("%1 %2").arg(name).arg(grade);
+			for (int a = 0; a < ALIASES_PER_BOOK; ++a) {
+				aliases << QString("b%1-%2").arg(grade * 1000 + b).arg(a);
+				aliasIsbns << isbn;
+			}
+		}
+	a_isbn = isbns.first().toString();
+	a_alias = aliases.last().toString();
+
+	QVariantList ids, studentNames, vajahre, kbuchst, swapIds, swapIsbns, swapDates, lendIds, lendIsbns, lendCounts,
+		lendDates;
+	QDate date(schoolYearSum() - 13, 9, 14);
+	int id = 0;
+	for (int grade = FIRST_GRADE; grade <= LAST_GRADE; ++grade)
+		for (int form = 0; form < FORMS_PER_GRADE; ++form)
+			for (int s = 0; s < STUDENTS_PER_FORM; ++s) {
+				++id;
+				ids << id;
+				studentNames << QString("Schüler%1 Vorname%2").arg(id).arg(s);
+				vajahre << schoolYearSum() - grade;
+				kbuchst << (grade <= LAST_LETTERED_GRADE ? QVariant(QString(QChar('a' + form)))
+									 : QVariant(QVariant::String));
+				for (int b = 0; b < BOOKS_PER_GRADE; ++b)
+					if ((id * 7 + b) % 10 != 0) {
+						swapIds << id;
+						swapIsbns << 9783000000000LL + grade * 1000 + b;
+						swapDates << date;
+					}
+				if (grade > FIRST_GRADE && id % 4 == 0) {
+					lendIds << id;
+					lendIsbns << 9783000000000LL + (grade - 1) * 1000 + id % BOOKS_PER_GRADE;
+					lendCounts << 1;
+					lendDates << date;
+				}
+			}
+
+	db.transaction();
+	bool ok = m_insert("INSERT INTO `buch` VALUES (?, ?, ?, ?)", QList<QVariantList>() << isbns << names << jgsts
+			   << titles)
+		&& m_insert("INSERT INTO `aliasse` VALUES (?, ?)", QList<QVariantList>() << aliases << aliasIsbns)
+		&& m_insert("INSERT INTO `schueler` VALUES (?, ?, ?, ?)", QList<QVariantList>() << ids << studentNames
+			    << vajahre << kbuchst)
+		&& m_insert("INSERT INTO `btausch` VALUES (?, ?, ?)", QList<QVariantList>() << swapIds << swapIsbns
+			    << swapDates)
+		&& m_insert("INSERT INTO `sausleihe` VALUES (?, ?, ?, ?)", QList<QVariantList>() << lendIds << lendIsbns
+			    << lendCounts << lendDates);
+	if (!ok) {
+		db.rollback();
+		return false;
+	}
+	return db.commit();
+}
+
+/*!
+ * \brief Schreibt eine CSV-Datei, wie sie der ImportDialog erwartet
+ * \param fileName Dateiname
+ * \param rows Anzahl der Zeilen
+ * \return true - Erfolg
+ *
+ * Jede zehnte Zeile enthält ein Feld in Anführungszeichen mit Trennzeichen und verdoppelten Anführungszeichen.
+ */
+bool Benchmark::m_writeCsv(QString fileName, int rows) {
+	QFile f(fileName);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	QTextStream out(&f);
+	out.setCodec("UTF-8");
+	for (int i = 0; i < rows; ++i) {
+		out << QString("Müller%1 Jürgen;%2%3").arg(i).arg(FIRST_GRADE + i % 8).arg(QChar('a' + i % FORMS_PER_GRADE));
+		if (i % 10 == 0)
+			out << ";\"Bemerkung; mit \"\"Zitat\"\"\"";
+		out << "\n";
+	}
+	return out.status() == QTextStream::Ok;
+}
+
+/*!
+ * \brief Lädt die Headers und ggf. die Daten der Listenansicht für a_form
+ * \param model Zu ladendes Modell
+ * \param data true - auch loadData() ausführen
+ * \return true - alles rechtzeitig geladen
+ */
+bool Benchmark::m_loadList(ListModel *model, bool data) {
+	model->setForm(a_form);
+	model->setDisplayedForm(a_form.left(a_form.indexOf(QRegExp("\\D"))).toInt());
+	QSignalSpy reset(model, SIGNAL(modelReset()));
+	model->loadHeader();
+	if (!reset.wait(60000))
+		return false;
+	if (!data)
+		return true;
+	QSignalSpy loaded(model, SIGNAL(loaded()));
+	model->loadData();
+	return loaded.wait(60000);
+}
+
+/*!
+ * \brief Richtet Datenbank, QueryExecutor, BookIndex und die CSV-Dateien ein
+ */
+void Benchmark::initTestCase() {
+	QVERIFY(a_dir.isValid());
+	if (qgetenv("OBSIDIAN_BENCH_DB") == "mysql") {
+		QVERIFY(m_openMysql());
+		a_form = QString::fromLocal8Bit(qgetenv("OBSIDIAN_BENCH_FORM"));
+		if (a_form.isEmpty())
+			a_form = "7a";
+		QSqlQuery q("SELECT `alias`, `isbn` FROM `aliasse` LIMIT 1");
+		if (q.next()) {
+			a_alias = q.value(0).toString();
+			a_isbn = q.value(1).toString();
+		}
+	} else {
+		QVERIFY(m_createDatabase());
+		a_form = "7a";
+	}
+
+	a_stats.reset(new QueryStats(QString(), SLOW_QUERY_MS));
+	a_executor.reset(new QueryExecutor);
+	a_books.reset(new BookIndex);
+	QSignalSpy reloaded(a_books.data(), SIGNAL(reloaded()));
+	a_books->reload();
+	QVERIFY(reloaded.wait(60000));
+
+	QVERIFY(m_writeCsv(a_dir.path() + "/import-1k.csv", 1000));
+	QVERIFY(m_writeCsv(a_dir.path() + "/import-100k.csv", 100000));
+}
+
+/*!
+ * \brief Beendet den QueryExecutor vor der Datenbankverbindung
+ */
+void Benchmark::cleanupTestCase() {
+	a_books.reset();
+	a_executor.reset();
+	a_stats.reset();
+}
+
+/*!
+ * \brief ListModel::loadHeader() bis zum Zurücksetzen des Modells
+ */
+void Benchmark::listHeader() {
+	ListModel model;
+	QVERIFY(m_loadList(&model, false));
+	QSignalSpy reset(&model, SIGNAL(modelReset()));
+	QBENCHMARK {
+		model.loadHeader();
+		QVERIFY(reset.wait(60000));
+	}
+	QVERIFY(model.rowCount(QModelIndex()) > 0);
+	QVERIFY(model.columnCount(QModelIndex()) > 0);
+}
+
+/*!
+ * \brief ListModel::loadData() bis loaded()
+ */
+void Benchmark::listData() {
+	ListModel model;
+	QVERIFY(m_loadList(&model, true));
+	QSignalSpy loaded(&model, SIGNAL(loaded()));
+	QBENCHMARK {
+		model.loadData();
+		QVERIFY(loaded.wait(60000));
+	}
+}
+
+/*!
+ * \brief ListModel::data() für alle Zellen, wie beim Zeichnen der gesamten Tabelle
+ */
+void Benchmark::listCells() {
+	ListModel model;
+	QVERIFY(m_loadList(&model, true));
+	int rows = model.rowCount(QModelIndex());
+	int columns = model.columnCount(QModelIndex());
+	int checked = 0;
+	QBENCHMARK {
+		checked = 0;
+		for (int r = 0; r < rows; ++r)
+			for (int c = 0; c < columns; ++c) {
+				QModelIndex index = model.index(r, c);
+				if (model.data(index, Qt::CheckStateRole).toInt() == Qt::Checked)
+					++checked;
+				model.data(index, Qt::BackgroundRole);
+			}
+	}
+	QVERIFY(checked > 0);
+}
+
+/*!
+ * \brief Testdaten für importCsv()
+ */
+void Benchmark::importCsv_data() {
+	QTest::addColumn<QString>("fileName");
+	QTest::addColumn<int>("rows");
+	QTest::newRow("1k") << a_dir.path() + "/import-1k.csv" << 1000;
+	QTest::newRow("100k") << a_dir.path() + "/import-100k.csv" << 100000;
+}
+
+/*!
+ * \brief ImportModel::setFileName() bis loaded()
+ *
+ * Jede Wiederholung benutzt ein neues ImportModel, damit der Zwischenspeicher nicht greift.
+ */
+void Benchmark::importCsv() {
+	QFETCH(QString, fileName);
+	QFETCH(int, rows);
+	QBENCHMARK {
+		ImportModel model;
+		QSignalSpy loaded(&model, SIGNAL(loaded()));
+		model.setFileName(fileName, '\n', ';');
+		QVERIFY(loaded.wait(60000));
+		QCOMPARE(model.rowCount(QModelIndex()), rows);
+	}
+}
+
+/*!
+ * \brief Testdaten für escapeString()
+ */
+void Benchmark::escapeString_data() {
+	QTest::addColumn<QString>("text");
+	QTest::newRow("name") << QString("Müller Jürgen");
+	QTest::newRow("quotes") << QString("O'Neill \"Jr.\" C:\\Schule\n");
+	QTest::newRow("long") << QString("Ein 'langer' Text mit \"Zitaten\"\\ ").repeated(100);
+}
+
+/*!
+ * \brief escape()
+ */
+void Benchmark::escapeString() {
+	QFETCH(QString, text);
+	QString result;
+	QBENCHMARK {
+		result = escape(text);
+	}
+	QVERIFY(result.size() >= text.size());
+}
+
+/*!
+ * \brief Testdaten für findFilter()
+ */
+void Benchmark::findFilter_data() {
+	QTest::addColumn<int>("tab");
+	QTest::newRow("sausleihe") << 0;
+	QTest::newRow("lausleihe") << 1;
+	QTest::newRow("btausch") << 2;
+	QTest::newRow("aliasse") << 3;
+	QTest::newRow("schueler") << 4;
+	QTest::newRow("lehrer") << 5;
+	QTest::newRow("buch") << 6;
+}
+
+/*!
+ * \brief FindDialog::getFilter() mit allen Feldern des Tabs ausgefüllt
+ *
+ * Jedes Feld erhält den ersten Text, den sein Validator akzeptiert; Datumsfelder werden vom Vorgabewert weg
+ * gesetzt, damit auch ihre Bedingungen erzeugt werden.
+ */
+void Benchmark::findFilter() {
+	QFETCH(int, tab);
+	FindDialog dialog(tab);
+	QWidget *page = dialog.findChild<QTabWidget *>()->widget(tab);
+	QStringList candidates = QStringList() << "Müller Jürgen" << "7a" << "2015" << "b";
+	foreach (QLineEdit *edit, page->findChildren<QLineEdit *>(QString(), Qt::FindDirectChildrenOnly))
+		foreach (QString text, candidates) {
+			int pos = 0;
+			if (!edit->validator() || edit->validator()->validate(text, pos) == QValidator::Acceptable) {
+				edit->setText(text);
+				break;
+			}
+		}
+	foreach (QDateEdit *edit, page->findChildren<QDateEdit *>(QString(), Qt::FindDirectChildrenOnly))
+		edit->setDate(QDate(2015, 9, 14));
+
+	QString filter;
+	QBENCHMARK {
+		filter = dialog.getFilter();
+	}
+	QVERIFY(!filter.isEmpty());
+}
+
+/*!
+ * \brief Testdaten für bookLookup()
+ */
+void Benchmark::bookLookup_data() {
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<bool>("database");
+	QTest::addColumn<bool>("found");
+	QTest::newRow("index alias") << a_alias << false << true;
+	QTest::newRow("index isbn") << a_isbn << false << true;
+	QTest::newRow("index unknown") << QString("kein-buch") << false << false;
+	QTest::newRow("database alias") << a_alias << true << true;
+	QTest::newRow("database isbn") << a_isbn << true << true;
+	QTest::newRow("database unknown") << QString("kein-buch") << true << false;
+}
+
+/*!
+ * \brief Auflösung eines eingescannten Textes wie in BaseDialog::bookLookup()
+ *
+ * Einmal über den BookIndex, einmal über dieselbe Abfrage, mit der BaseDialog vor dem Laden des Verzeichnisses
+ * auf die Datenbank ausweicht (Hin- und Rückweg durch den QueryExecutor eingeschlossen).
+ */
+void Benchmark::bookLookup() {
+	QFETCH(QString, text);
+	QFETCH(bool, database);
+	QFETCH(bool, found);
+	if (text.isEmpty())
+		QSKIP("Die Datenbank enthält keine Aliasse");
+
+	if (!database) {
+		BookIndex::Book book;
+		BookIndex::Lookup lookup = BookIndex::NotLoaded;
+		QBENCHMARK {
+			lookup = BookIndex::instance()->lookup(text, &book);
+		}
+		QCOMPARE(lookup == BookIndex::Found, found);
+		return;
+	}
+
+	QVariantMap values;
+	values[":alias"] = text.toLower();
+	values[":isbn"] = BookIndex::normalizeIsbn(text);
+	QSignalSpy finished(QueryExecutor::instance(), SIGNAL(finished(QueryResult)));
+	QueryResult result;
+	QBENCHMARK {
+		finished.clear();
+		QueryExecutor::instance()->submit(QueryExecutor::channel(this, "lookup"),
+			QueryRequest("SELECT `isbn`, `name`, `jgst` FROM `buch` WHERE `isbn` = "
+				     "IFNULL((SELECT `isbn` FROM `aliasse` WHERE `alias` = :alias), :isbn)", values));
+		QVERIFY(finished.wait(60000));
+		result = finished.takeFirst().at(0).value<QueryResult>();
+	}
+	QVERIFY2(result.ok(), qPrintable(result.error.text()));
+	QCOMPARE(!result.sets.value(0).rows.isEmpty(), found);
+}
+
+/*!
+ * \brief Hauptprogramm der Benchmarks
+ *
+ * Sofern nicht anders eingestellt, wird die Plattform "offscreen" benutzt, damit die Benchmarks auch ohne Display
+ * laufen, z.B. auf einem Build-Server.
+ * Die Argumente sind die von QTest, z.B. -iterations, -minimumvalue oder -o ergebnis.csv,csv.
+ */
+int main(int argc, char *argv[]) {
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+	QApplication a(argc, argv);
+	QCoreApplication::setApplicationName(APP_NAME);
+	QCoreApplication::setOrganizationName(ORG_NAME);
+	QCoreApplication::setOrganizationDomain(ORG_DOMAIN);
+
+	Benchmark benchmark;
+	return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "benchmark.moc"
@@ -3,18 +3,24 @@ CREATE DEFINER=`root`@`localhost` FUNCTION `klasse_berechnen`(`vajahr` SMALLINT)
 BEGIN IF MONTH(CURDATE()) >= 9 THEN RETURN(13+YEAR(CURDATE())-`vajahr`); ELSE RETURN(12+YEAR(CURDATE())-`vajahr`); END IF; END$$
 DELIMITER ;
 
+-- Die FULLTEXT-Indizes benutzen den ngram-Parser (ab MySQL 5.7.6), damit auch Teilwörter gefunden werden.
+-- Ohne Stoppwörter, da sonst alle Bigramme wie "an" oder "in" fehlen würden.
+SET SESSION innodb_ft_enable_stopword = OFF;
+
 CREATE TABLE `buch` (
   `isbn` bigint(20) NOT NULL,
   `name` varchar(50) NOT NULL,
   `jgst` varchar(10) DEFAULT NULL,
-  PRIMARY KEY (`isbn`)
+  PRIMARY KEY (`isbn`),
+  FULLTEXT KEY `ft_name` (`name`) WITH PARSER ngram
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 CREATE TABLE `lehrer` (
   `id` int(11) NOT NULL AUTO_INCREMENT,
   `name` varchar(50) NOT NULL,
   `kuerzel` varchar(4) DEFAULT NULL,
-  PRIMARY KEY (`id`)
+  PRIMARY KEY (`id`),
+  FULLTEXT KEY `ft_name` (`name`) WITH PARSER ngram
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 CREATE TABLE `schueler` (
@@ -22,7 +28,10 @@ CREATE TABLE `schueler` (
   `name` varchar(50) NOT NULL,
   `vajahr` int(11) DEFAULT NULL,
   `kbuchst` varchar(3) DEFAULT NULL,
-  PRIMARY KEY (`id`)
+  PRIMARY KEY (`id`),
+  KEY `klasse` (`vajahr`,`kbuchst`),
+  KEY `name` (`name`),
+  FULLTEXT KEY `ft_name` (`name`) WITH PARSER ngram
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 CREATE TABLE `sausleihe` (
@@ -32,6 +41,7 @@ CREATE TABLE `sausleihe` (
   `adatum` date DEFAULT NULL,
   PRIMARY KEY (`sid`,`bid`),
   KEY `fk_bid` (`bid`),
+  KEY `adatum` (`adatum`),
   CONSTRAINT `sausleihe_ibfk_1` FOREIGN KEY (`sid`) REFERENCES `schueler` (`id`),
   CONSTRAINT `sausleihe_ibfk_2` FOREIGN KEY (`bid`) REFERENCES `buch` (`isbn`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
@@ -43,6 +53,7 @@ CREATE TABLE `lausleihe` (
   `adatum` date DEFAULT NULL,
   PRIMARY KEY (`lid`,`bid`),
   KEY `fk_bid` (`bid`),
+  KEY `adatum` (`adatum`),
   CONSTRAINT `lausleihe_ibfk_1` FOREIGN KEY (`lid`) REFERENCES `lehrer` (`id`),
   CONSTRAINT `lausleihe_ibfk_2` FOREIGN KEY (`bid`) REFERENCES `buch` (`isbn`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
@@ -53,6 +64,7 @@ CREATE TABLE `btausch` (
   `datum` date DEFAULT NULL,
   PRIMARY KEY (`sid`,`bid`),
   KEY `fk_bid` (`bid`),
+  KEY `datum` (`datum`),
   CONSTRAINT `btausch_ibfk_1` FOREIGN KEY (`sid`) REFERENCES `schueler` (`id`),
   CONSTRAINT `btausch_ibfk_2` FOREIGN KEY (`bid`) REFERENCES `buch` (`isbn`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
@@ -66,6 +78,18 @@ CREATE TABLE `aliasse` (
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 
+-- Stand der Migrationen (siehe Migrator); dieses Skript enthält bereits alle
+CREATE TABLE `schema_version` (
+  `version` int(11) NOT NULL,
+  `beschreibung` varchar(100) NOT NULL,
+  `angewendet` datetime NOT NULL,
+  PRIMARY KEY (`version`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+INSERT INTO `schema_version` VALUES
+  (1, 'Indizes für Klassen, Namen und Ausleihdaten', NOW()),
+  (2, 'FULLTEXT-Indizes (ngram) für die Suche nach Namen und Titeln', NOW());
+
 CREATE ALGORITHM=UNDEFINED DEFINER=CURRENT_USER() SQL SECURITY DEFINER VIEW `biblio`.`Btausch` AS select `biblio`.`btausch`.`sid` AS `a`,`biblio`.`btausch`.`sid` AS `b`,`biblio`.`btausch`.`bid` AS `bid`,`biblio`.`btausch`.`datum` AS `datum` from `biblio`.`btausch`;
 CREATE ALGORITHM=UNDEFINED DEFINER=CURRENT_USER() SQL SECURITY DEFINER VIEW `biblio`.`Buch` AS select `biblio`.`buch`.`isbn` AS `isbn`,ifnull(concat(`biblio`.`buch`.`name`,' ',`biblio`.`buch`.`jgst`),`biblio`.`buch`.`name`) AS `titel` from `biblio`.`buch`;
 CREATE ALGORITHM=UNDEFINED DEFINER=CURRENT_USER() SQL SECURITY DEFINER VIEW `biblio`.`SSchueler` AS select `biblio`.`schueler`.`id` AS `id`,concat(cast(`klasse_berechnen`(`biblio`.`schueler`.`vajahr`) as char charset utf8),ifnull(`biblio`.`schueler`.`kbuchst`,'')) AS `Klasse`,`biblio`.`schueler`.`name` AS `Name` from `biblio`.`schueler`;
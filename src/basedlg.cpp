@@ -1,5 +1,6 @@
 #include "basedlg.h"
 #include "selectdlg.h"
+#include "bookindex.h"
 #include <QtCore>
 #include <QtGui>
 #include <QtWidgets>
@@ -84,6 +85,7 @@ void BaseDialog::m_connectComponents() {
 	connect(a_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 	connect(a_student, SIGNAL(toggled(bool)), this, SLOT(toggle()));
 	connect(a_teacher, SIGNAL(toggled(bool)), this, SLOT(toggle()));
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(bookFound(QueryResult)));
 
 	for (int i = 0; i < a_numIsbns; ++i)
 		connect(a_alias[i], SIGNAL(editingFinished()), this, SLOT(bookLookup()));
@@ -127,34 +129,113 @@ void BaseDialog::toggle() {
 /*!
  * \brief Wird beim Verlassen eines a_alias-Feldes aufgerufen
  *
- * Eine SQL-Abfrage nach soeben eingegebenen ISBN wird ausgeführt und im
- * a_title-Feld neben dem a_alias-Feld wird der Titel des gerade eingescannten
- * Buches angezeigt.
+ * Die soeben eingegebene ISBN bzw. der Alias wird im gemeinsamen BookIndex aufgelöst, ohne
+ * die Datenbank zu fragen. Nur solange dieser noch nicht geladen ist, wird die Suche als eine
+ * einzige Abfrage an den QueryExecutor übergeben; eine noch laufende Suche für dasselbe Feld
+ * wird dabei verworfen und das Ergebnis in bookFound() ausgewertet.
  */
 void BaseDialog::bookLookup() {
 	QString text = qobject_cast<QLineEdit *>(sender())->text();
 	int i;
 
-	if (text == QString())
-		return;
 	for (i = 0; i < a_numIsbns; ++i)
 		if (a_alias[i] == sender())
 			break;
+	a_isbn[i].clear();
+	a_title[i]->clear();
+	if (text == QString()) {
+		QueryExecutor::instance()->cancel(QueryExecutor::channel(this, QString("lookup%1").arg(i)));
+		a_lookups.remove(i);
+		return;
+	}
+
+	BookIndex::Book book;
+	switch (BookIndex::instance()->lookup(text, &book)) {
+	case BookIndex::Found:
+		a_lookups.remove(i);
+		m_showBook(i, book.isbn, book.title());
+		return;
+	case BookIndex::NotFound:
+		a_lookups.remove(i);
+		m_showBook(i, BookIndex::normalizeIsbn(text), QString());
+		return;
+	case BookIndex::NotLoaded:
+		break;
+	}
+
+	QVariantMap values;
+	values[":alias"] = text.toLower();
+	values[":isbn"] = BookIndex::normalizeIsbn(text);
+	a_lookups[i] = QueryExecutor::instance()->submit(QueryExecutor::channel(this, QString("lookup%1").arg(i)),
+		QueryRequest("SELECT `isbn`, `name`, `jgst` FROM `buch` WHERE `isbn` = "
+			     "IFNULL((SELECT `isbn` FROM `aliasse` WHERE `alias` = :alias), :isbn)", values));
+}
 
-	a_q.prepare("SELECT * FROM `aliasse` WHERE `alias` = :alias");
-	a_q.bindValue(":alias", text.toLower());
-	a_q.exec();
-	if (a_q.next())
-		a_isbn[i] = a_q.value("isbn").toString();
-	else if (a_q.size() == 0)
-		a_isbn[i] = text;
-	a_q.prepare("SELECT * FROM `buch` WHERE `isbn` = :isbn");
-	a_q.bindValue(":isbn", a_isbn[i]);
-
-	if (!a_q.exec() || !a_q.first()) {
-		QMessageBox::warning(this, tr("Buch nicht gefunden"),
-				     tr("Das Buch mit der ISBN %1 konnte nicht gefunden werden.").arg(text));
+/*!
+ * \brief Wertet das Ergebnis einer Suche aus bookLookup() aus
+ * \param result Ergebnis eines beliebigen Auftrags
+ *
+ * Das Ergebnis wird mit m_showBook() angezeigt.
+ */
+void BaseDialog::bookFound(QueryResult result) {
+	int i = a_lookups.key(result.ticket, -1);
+	if (i == -1)
+		return;
+	a_lookups.remove(i);
+	if (!result.ok()) {
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+	if (result.sets.value(0).rows.isEmpty()) {
+		m_showBook(i, BookIndex::normalizeIsbn(a_alias[i]->text()), QString());
 		return;
 	}
-	a_title[i]->setText(QString("%1 %2").arg(a_q.value("name").toString()).arg(a_q.value("jgst").toString()));
+	const QVariantList &row = result.sets[0].rows[0];
+	m_showBook(i, row[0].toString(), QString("%1 %2").arg(row[1].toString()).arg(row[2].toString()));
+}
+
+/*!
+ * \brief Zeigt das Ergebnis einer Buchsuche neben dem ISBN-Feld an
+ * \param i Index des ISBN-Feldes
+ * \param isbn Aufgelöste ISBN (bzw. der eingegebene Text, falls nichts gefunden wurde)
+ * \param title Titel des Buches oder "", falls das Buch nicht gefunden wurde
+ *
+ * Ein nicht gefundenes Buch wird nicht mehr mit einem modalen Dialog gemeldet, sondern rot im
+ * a_title-Feld markiert, damit ohne Unterbrechung weiter eingescannt werden kann.
+ */
+void BaseDialog::m_showBook(int i, QString isbn, QString title) {
+	a_isbn[i] = isbn;
+	if (title.isEmpty()) {
+		a_title[i]->setStyleSheet("color: red");
+		a_title[i]->setText(tr("Buch %1 nicht gefunden!").arg(a_alias[i]->text()));
+		QApplication::beep();
+	} else {
+		a_title[i]->setStyleSheet(QString());
+		a_title[i]->setText(title);
+	}
+}
+
+/*!
+ * \brief Gibt die ISBN-Felder an, in die etwas eingescannt wurde
+ * \return Indizes der nicht leeren a_alias-Felder
+ */
+QList<int> BaseDialog::m_scannedFields() const {
+	QList<int> fields;
+	for (int i = 0; i < a_numIsbns; ++i)
+		if (!a_alias[i]->text().isEmpty())
+			fields << i;
+	return fields;
+}
+
+/*!
+ * \brief Prüft, ob noch Bücher gesucht werden
+ * \return true - Es laufen noch Suchen, der Dialog darf noch nicht abgeschlossen werden
+ *
+ * Gegebenenfalls wird der Benutzer darauf hingewiesen.
+ */
+bool BaseDialog::m_lookupsPending() {
+	if (a_lookups.isEmpty())
+		return false;
+	QMessageBox::information(this, tr("Bitte warten"), tr("Die eingescannten Bücher werden noch gesucht."));
+	return true;
 }
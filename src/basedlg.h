@@ -2,10 +2,11 @@
 #define BASEDLG_H
 
 #include "main.h"
+#include "executor.h"
 #include <QDialog>
 #include <QWidget>
 #include <QSqlRecord>
-#include <QSqlQuery>
+#include "querystats.h"
 #include <QLabel>
 #include <QLineEdit>
 #include <QGroupBox>
@@ -20,6 +21,7 @@ class BaseDialog : public QDialog {
 	Q_OBJECT
 public:
 	BaseDialog(bool endOfTerm, QWidget *parent = 0);
+	QList<QPair<int, QString>> changedLendings() const {return a_changed;}
 
 protected:
 	void m_createInterface(QSqlRecord record = QSqlRecord());
@@ -27,12 +29,17 @@ protected:
 	virtual void m_alignComponents() = 0;
 	virtual void m_setInitialValues(QSqlRecord record);
 	virtual void m_connectComponents();
+	bool m_lookupsPending();
+	void m_showBook(int i, QString isbn, QString title);
+	QList<int> m_scannedFields() const;
 
 	static constexpr int a_numIsbns = 16;    ///< Anzahl der ISBN-Felder
 	int a_id;                                ///< Id des Schülers/Lehrers
 	bool a_eot;                              ///< Ist es eine normale Ausleihe mitten im Schuljahr?
 	QString a_isbn[a_numIsbns];                  ///< Enthält die eindeutige ISBN des Buches
-	QSqlQuery a_q;                           ///< Zu verwendendes QSqlQuery-Objekt
+	QList<QPair<int, QString>> a_changed;    ///< Vom Dialog tatsächlich geänderte Ausleihen (Id, ISBN)
+	QMap<int, int> a_lookups;                ///< Zuordnung ISBN-Feld->ausstehender Suchauftrag
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
 	QLabel *a_name;                          ///< Enthält den Namen des Schülers/Lehrers
 	QLabel *a_form;                          ///< Enthält die Klasse des Schülers/das Kürzel des Lehrers
 	QLabel *a_title[a_numIsbns];             ///< Enthält den Titel des Buches
@@ -47,6 +54,7 @@ protected slots:
 	void chooseLender();
 	void toggle();
 	void bookLookup();
+	void bookFound(QueryResult result);
 };
 
 #endif
@@ -0,0 +1,150 @@
+#include "bookindex.h"
+#include "main.h"
+#include <QRegExp>
+
+BookIndex *BookIndex::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von BookIndex
+ * \param parent Elternobjekt
+ *
+ * Das Verzeichnis ist zunächst leer; geladen wird es erst mit reload().
+ */
+BookIndex::BookIndex(QObject *parent) : QObject(parent), a_loaded(false), a_ticket(0) {
+	s_instance = this;
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(loadResult(QueryResult)));
+}
+
+/*!
+ * \brief Destruktor von BookIndex
+ */
+BookIndex::~BookIndex() {
+	if (s_instance == this)
+		s_instance = 0;
+}
+
+/*!
+ * \brief Gibt die Instanz der Anwendung zurück
+ * \return Der in main() erzeugte BookIndex
+ */
+BookIndex *BookIndex::instance() {
+	Q_ASSERT(s_instance);
+	return s_instance;
+}
+
+/*!
+ * \brief Lädt `buch` und `aliasse` im Hintergrund neu
+ *
+ * Bis das Ergebnis da ist, bleibt der bisherige Stand gültig.
+ */
+void BookIndex::reload() {
+	a_ticket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "reload"), QList<QueryRequest>()
+		<< QueryRequest("SELECT `isbn`, `name`, `jgst` FROM `buch`")
+		<< QueryRequest("SELECT `alias`, `isbn` FROM `aliasse`"));
+}
+
+/*!
+ * \brief Übernimmt das Ergebnis von reload()
+ * \param result Ergebnis eines beliebigen Auftrags
+ */
+void BookIndex::loadResult(QueryResult result) {
+	if (result.ticket != a_ticket)
+		return;
+	a_ticket = 0;
+	if (!result.ok()) {
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+
+	const QueryResultSet &books = result.sets[0];
+	const QueryResultSet &aliases = result.sets[1];
+	a_books.clear();
+	a_books.reserve(books.rows.size());
+	foreach (const QVariantList &row, books.rows) {
+		Book b;
+		b.isbn = row[0].toString();
+		b.name = row[1].toString();
+		b.jgst = row[2].toString();
+		a_books.insert(b.isbn, b);
+	}
+	a_aliases.clear();
+	a_aliases.reserve(aliases.rows.size());
+	foreach (const QVariantList &row, aliases.rows)
+		a_aliases.insert(row[0].toString().toLower(), row[1].toString());
+	a_loaded = true;
+	emit reloaded();
+}
+
+/*!
+ * \brief Bringt eine eingegebene ISBN in die Form der Spalte `buch`.`isbn`
+ * \param text Eingabe
+ * \return ISBN-13 als Zahl ohne führende Nullen oder text, wenn es keine ISBN ist
+ *
+ * Bindestriche und Leerzeichen werden entfernt. Eine ISBN-10 mit gültiger Prüfziffer (auch "X") wird in die
+ * ISBN-13 mit dem Präfix 978 umgerechnet; andere Ziffernfolgen werden wie der bigint in der Datenbank
+ * ohne führende Nullen dargestellt. Aliasse bleiben unverändert.
+ */
+QString BookIndex::normalizeIsbn(QString text) {
+	QString digits = text;
+	digits.remove('-').remove(' ');
+	if (digits.size() == 10 && QRegExp("[0-9]{9}[0-9Xx]").exactMatch(digits)) {
+		int sum = 0;
+		for (int i = 0; i < 10; ++i)
+			sum += (10 - i) * (digits[i].toUpper() == 'X' ? 10 : digits[i].digitValue());
+		if (sum % 11 == 0) {
+			digits = "978" + digits.left(9);
+			sum = 0;
+			for (int i = 0; i < 12; ++i)
+				sum += (i % 2 == 0 ? 1 : 3) * digits[i].digitValue();
+			digits += QString::number((10 - sum % 10) % 10);
+		}
+	}
+	bool ok;
+	qlonglong number = digits.toLongLong(&ok);
+	if (!ok || number <= 0 || !QRegExp("[0-9]+").exactMatch(digits))
+		return text;
+	return QString::number(number);
+}
+
+/*!
+ * \brief Löst einen eingescannten Text auf
+ * \param text Alias oder ISBN
+ * \param book Nimmt das gefundene Buch auf
+ * \return Found, NotFound oder NotLoaded, falls noch nichts geladen wurde
+ *
+ * Wie bisher in der Datenbank wird zuerst unter den Aliassen gesucht und der Text nur dann als ISBN
+ * betrachtet (siehe normalizeIsbn()), wenn es keinen passenden Alias gibt.
+ */
+BookIndex::Lookup BookIndex::lookup(QString text, Book *book) const {
+	if (!a_loaded)
+		return NotLoaded;
+	QString isbn = a_aliases.value(text.toLower(), normalizeIsbn(text));
+	QHash<QString, Book>::const_iterator i = a_books.constFind(isbn);
+	if (i == a_books.constEnd())
+		return NotFound;
+	*book = i.value();
+	return Found;
+}
+
+/*!
+ * \brief Trägt ein neu eingefügtes Buch ein
+ * \param isbn ISBN
+ * \param name Titel
+ * \param jgst Jahrgangsstufe(n)
+ */
+void BookIndex::insertBook(QString isbn, QString name, QString jgst) {
+	Book b;
+	b.isbn = isbn;
+	b.name = name;
+	b.jgst = jgst;
+	a_books.insert(isbn, b);
+}
+
+/*!
+ * \brief Trägt einen neu eingefügten Alias ein
+ * \param alias Alias
+ * \param isbn ISBN, für die der Alias steht
+ */
+void BookIndex::insertAlias(QString alias, QString isbn) {
+	a_aliases.insert(alias.toLower(), isbn);
+}
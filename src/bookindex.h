@@ -0,0 +1,65 @@
+#ifndef BOOKINDEX_H
+#define BOOKINDEX_H
+
+#include "executor.h"
+#include <QObject>
+#include <QHash>
+
+/*!
+ * \brief Im Speicher gehaltenes Verzeichnis aller Bücher und Aliasse
+ *
+ * `buch` und `aliasse` werden einmal (im Hintergrund) geladen und danach von allen Dialogen
+ * gemeinsam benutzt, damit eingescannte Bücher ohne Datenbankzugriff aufgelöst werden können.
+ */
+class BookIndex : public QObject {
+	Q_OBJECT
+public:
+	/*!
+	 * \brief Ein Buch aus `buch`
+	 */
+	struct Book {
+		QString isbn;                    ///< ISBN des Buches
+		QString name;                    ///< Titel des Buches
+		QString jgst;                    ///< Jahrgangsstufe(n) des Buches
+
+		QString title() const {return QString("%1 %2").arg(name).arg(jgst);}
+	};
+
+	/*!
+	 * \brief Ergebnis von lookup()
+	 */
+	enum Lookup {
+		Found,                           ///< Das Buch wurde gefunden
+		NotFound,                        ///< Das Buch existiert nicht
+		NotLoaded                        ///< Das Verzeichnis ist noch nicht geladen
+	};
+
+private:
+	static BookIndex *s_instance;            ///< Die Instanz der Anwendung
+	QHash<QString, Book> a_books;            ///< Zuordnung ISBN->Buch
+	QHash<QString, QString> a_aliases;       ///< Zuordnung Alias (klein geschrieben)->ISBN
+	bool a_loaded;                           ///< Wurde das Verzeichnis schon einmal geladen?
+	int a_ticket;                            ///< Nummer des ausstehenden Ladeauftrags
+
+public:
+	BookIndex(QObject *parent = 0);
+	~BookIndex();
+	static BookIndex *instance();
+	static QString normalizeIsbn(QString text);
+
+	bool isLoaded() const {return a_loaded;}
+	Lookup lookup(QString text, Book *book) const;
+	void insertBook(QString isbn, QString name, QString jgst);
+	void insertAlias(QString alias, QString isbn);
+
+public slots:
+	void reload();
+
+private slots:
+	void loadResult(QueryResult result);
+
+signals:
+	void reloaded();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "columnsizer.h"
+#include <QHeaderView>
+#include <QStyle>
+
+/*!
+ * \brief Passt die Spaltenbreiten an
+ * \param view Tabelle
+ * \param key Schlüssel, unter dem die Breiten gespeichert werden (z.B. Index des Tabs)
+ *
+ * Gemessen wird nur, wenn für den Schlüssel noch nichts gespeichert ist, sich die Spalten geändert haben
+ * oder bei der letzten Messung noch keine Zeilen geladen waren. Sonst werden die gespeicherten Breiten gesetzt.
+ */
+void ColumnSizer::fit(QTableView *view, int key) {
+	if (!view->model())
+		return;
+	QString schema = m_schema(view);
+	int rows = view->model()->rowCount();
+
+	QHash<int, Entry>::iterator i = a_entries.find(key);
+	if (i == a_entries.end() || i->schema != schema || (i->rows == 0 && rows > 0)) {
+		Entry e;
+		QVector<int> sample = m_sample(rows);
+		e.schema = schema;
+		e.widths = m_measure(view, sample);
+		e.rows = sample.size();
+		i = a_entries.insert(key, e);
+	}
+
+	QHeaderView *header = view->horizontalHeader();
+	for (int c = 0; c < i->widths.size(); ++c)
+		if (header->sectionSize(c) != i->widths[c])
+			header->resizeSection(c, i->widths[c]);
+}
+
+/*!
+ * \brief Beschreibt die Spalten einer Tabelle
+ * \param view Tabelle
+ * \return Spaltenanzahl und alle Überschriften
+ */
+QString ColumnSizer::m_schema(const QTableView *view) {
+	QAbstractItemModel *model = view->model();
+	QStringList parts;
+	parts << QString::number(model->columnCount());
+	for (int c = 0; c < model->columnCount(); ++c)
+		parts << model->headerData(c, Qt::Horizontal, Qt::DisplayRole).toString();
+	return parts.join(QChar(0x1f));
+}
+
+/*!
+ * \brief Wählt die zu messenden Zeilen aus
+ * \param rows Anzahl der Zeilen
+ * \return Bei wenigen Zeilen alle, sonst die erste Hälfte der Stichprobe vom Anfang und den Rest gleichmäßig
+ *         über die übrigen Zeilen verteilt
+ */
+QVector<int> ColumnSizer::m_sample(int rows) {
+	QVector<int> sample;
+	if (rows <= a_sampleSize) {
+		for (int r = 0; r < rows; ++r)
+			sample << r;
+		return sample;
+	}
+	int head = a_sampleSize / 2;
+	int rest = a_sampleSize - head;
+	for (int r = 0; r < head; ++r)
+		sample << r;
+	for (int n = 0; n < rest; ++n)
+		sample << head + int(qint64(rows - head - 1) * n / (rest - 1));
+	return sample;
+}
+
+/*!
+ * \brief Misst die Breiten der Spalten
+ * \param view Tabelle
+ * \param rows Zu messende Zeilen
+ * \return Zuordnung Spalte->Breite
+ *
+ * Eine Spalte ist so breit wie ihr Header oder der breiteste Text der Stichprobe zuzüglich Rand; Zellen mit
+ * Ankreuzfeld bekommen zusätzlich dessen Breite.
+ */
+QVector<int> ColumnSizer::m_measure(const QTableView *view, const QVector<int> &rows) {
+	QAbstractItemModel *model = view->model();
+	QFontMetrics fm(view->font());
+	QStyle *style = view->style();
+	int margin = 2 * (style->pixelMetric(QStyle::PM_FocusFrameHMargin, 0, view) + 1) + (view->showGrid() ? 1 : 0);
+	int indicator = style->pixelMetric(QStyle::PM_IndicatorWidth, 0, view) + margin;
+	QVector<int> widths(model->columnCount());
+
+	for (int c = 0; c < widths.size(); ++c) {
+		int width = view->horizontalHeader()->sectionSizeHint(c);
+		foreach (int r, rows) {
+			QModelIndex index = model->index(r, c);
+			int w = fm.width(model->data(index, Qt::DisplayRole).toString()) + margin;
+			if (model->data(index, Qt::CheckStateRole).isValid())
+				w += indicator;
+			width = qMax(width, w);
+		}
+		widths[c] = width;
+	}
+	return widths;
+}
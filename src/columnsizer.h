@@ -0,0 +1,38 @@
+#ifndef COLUMNSIZER_H
+#define COLUMNSIZER_H
+
+#include <QTableView>
+#include <QHash>
+#include <QVector>
+
+/*!
+ * \brief Passt die Spaltenbreiten einer Tabelle an, ohne alle Zeilen zu vermessen
+ *
+ * Ersatz für QTableView::resizeColumnsToContents(): Gemessen werden nur der Header und eine begrenzte
+ * Stichprobe von höchstens a_sampleSize Zeilen. Die Breiten werden pro Tabelle (Schlüssel) gespeichert und
+ * erst wieder neu gemessen, wenn sich die Spalten (Anzahl oder Überschriften) ändern.
+ */
+class ColumnSizer {
+private:
+	/*!
+	 * \brief Gespeicherte Breiten einer Tabelle
+	 */
+	struct Entry {
+		QString schema;                  ///< Spaltenanzahl und Überschriften bei der Messung
+		QVector<int> widths;             ///< Zuordnung Spalte->Breite
+		int rows;                        ///< Anzahl der gemessenen Zeilen
+	};
+
+	static constexpr int a_sampleSize = 100; ///< Höchstzahl der gemessenen Zeilen
+	QHash<int, Entry> a_entries;             ///< Zuordnung Schlüssel->gespeicherte Breiten
+
+	static QString m_schema(const QTableView *view);
+	static QVector<int> m_sample(int rows);
+	static QVector<int> m_measure(const QTableView *view, const QVector<int> &rows);
+
+public:
+	void fit(QTableView *view, int key = 0);
+	void invalidate(int key) {a_entries.remove(key);}
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "csvparser.h"
+#include <QFile>
+#include <QTextCodec>
+#include <QTextDecoder>
+#include <QScopedPointer>
+
+/*!
+ * \brief Gibt die Anzahl der Felder einer Zeile an
+ * \param row Zeile
+ * \return Anzahl der Felder
+ */
+int CsvTable::fieldCount(int row) const {
+	return rowEnds[row] - (row == 0 ? 0 : rowEnds[row - 1]);
+}
+
+/*!
+ * \brief Gibt den Inhalt eines Feldes aus
+ * \param row Zeile
+ * \param column Spalte
+ * \return Inhalt des Feldes oder "", wenn die Zeile weniger Felder hat
+ */
+QString CsvTable::field(int row, int column) const {
+	if (row < 0 || row >= rowEnds.size() || column < 0 || column >= fieldCount(row))
+		return QString();
+	int f = (row == 0 ? 0 : rowEnds[row - 1]) + column;
+	int start = f == 0 ? 0 : fieldEnds[f - 1];
+	return text.mid(start, fieldEnds[f] - start);
+}
+
+/*!
+ * \brief Hängt die Zeilen einer anderen Tabelle an
+ * \param other Anzuhängende Zeilen
+ */
+void CsvTable::append(const CsvTable &other) {
+	int offset = text.size();
+	int fieldBase = fieldEnds.size();
+
+	text += other.text;
+	fieldEnds.reserve(fieldEnds.size() + other.fieldEnds.size());
+	foreach (int end, other.fieldEnds)
+		fieldEnds << end + offset;
+	rowEnds.reserve(rowEnds.size() + other.rowEnds.size());
+	foreach (int end, other.rowEnds)
+		rowEnds << end + fieldBase;
+	columnCount = qMax(columnCount, other.columnCount);
+}
+
+/*!
+ * \brief Leert die Tabelle
+ */
+void CsvTable::clear() {
+	text.clear();
+	fieldEnds.clear();
+	rowEnds.clear();
+	columnCount = 0;
+}
+
+/*!
+ * \brief Gibt den beim Anhängen zu viel reservierten Speicher frei
+ */
+void CsvTable::squeeze() {
+	text.squeeze();
+	fieldEnds.squeeze();
+	rowEnds.squeeze();
+}
+
+/*!
+ * \brief Liest eine Datei ein
+ * \param ticket Nummer des Auftrags
+ * \param fileName Dateiname
+ * \param rowSeparator Zeichen, das Datensätze voneinander trennt
+ * \param colSeparator Zeichen, das die Felder voneinander trennt
+ *
+ * Vor jedem Block wird geprüft, ob der Auftrag noch aktuell ist; ein veralteter Auftrag wird ohne weitere
+ * Meldung abgebrochen. Die Kodierung wird anhand eines BOM oder des ersten Blocks bestimmt: Ist dieser kein
+ * gültiges UTF-8, wird die Datei als Windows-1252 (Obermenge von Latin-1) gelesen. Stellt sich erst in einem
+ * späteren Block heraus, dass die Datei kein gültiges UTF-8 ist, wird sie nach restarted() von vorne als
+ * Windows-1252 gelesen.
+ */
+void CsvParser::parse(int ticket, QString fileName, QChar rowSeparator, QChar colSeparator) {
+	if (ticket != a_current.load())
+		return;
+	QFile f(fileName);
+	if (!f.open(QFile::ReadOnly)) {
+		emit finished(ticket, f.errorString());
+		return;
+	}
+
+	a_ticket = ticket;
+	a_rowSeparator = rowSeparator;
+	a_colSeparator = colSeparator;
+	a_state = FieldStart;
+	a_skipLf = false;
+	a_quoted = false;
+	a_chunk.clear();
+
+	QScopedPointer<QTextDecoder> decoder;
+	bool guessed = false;
+	while (!f.atEnd()) {
+		if (ticket != a_current.load())
+			return;
+		QByteArray block = f.read(a_blockSize);
+		if (block.isEmpty() && f.error() != QFile::NoError) {
+			emit finished(ticket, f.errorString());
+			return;
+		}
+		if (decoder.isNull()) {
+			QTextCodec *codec = QTextCodec::codecForUtfText(block, 0);
+			if (!codec) {
+				QTextCodec::ConverterState state;
+				QTextCodec::codecForName("UTF-8")->toUnicode(block.constData(), block.size(), &state);
+				codec = QTextCodec::codecForName(state.invalidChars > 0 ? "Windows-1252" : "UTF-8");
+				guessed = state.invalidChars == 0;
+			}
+			decoder.reset(codec->makeDecoder());
+		}
+		QString text = decoder->toUnicode(block);
+		if (guessed && decoder->hasFailure()) {
+			guessed = false;
+			decoder.reset(QTextCodec::codecForName("Windows-1252")->makeDecoder());
+			a_state = FieldStart;
+			a_skipLf = false;
+			a_quoted = false;
+			a_chunk.clear();
+			f.seek(0);
+			emit restarted(ticket);
+			continue;
+		}
+		m_feed(text);
+	}
+
+	if (a_state != FieldStart || a_chunk.fieldEnds.size() > (a_chunk.rowEnds.isEmpty() ? 0
+										      : a_chunk.rowEnds.last()))
+		m_endRow();
+	m_flush();
+	emit finished(ticket, QString());
+}
+
+/*!
+ * \brief Zerlegt ein Stück dekodierten Text
+ * \param text Text; Felder und Zeilen dürfen über das Ende hinausgehen
+ */
+void CsvParser::m_feed(const QString &text) {
+	for (int i = 0; i < text.size(); ++i) {
+		QChar c = text[i];
+		if (a_skipLf) {
+			a_skipLf = false;
+			if (c == '\n')
+				continue;
+		}
+		switch (a_state) {
+		case Quoted:
+			if (c == '"')
+				a_state = QuoteInQuoted;
+			else
+				a_chunk.text += c;
+			break;
+		case QuoteInQuoted:
+			if (c == '"') {
+				a_chunk.text += c;
+				a_state = Quoted;
+				break;
+			}
+			a_state = Unquoted;
+			// fall through
+		default:
+			if (c == a_colSeparator)
+				m_endField();
+			else if (c == a_rowSeparator)
+				m_endRow();
+			else if (c == '"' && a_state == FieldStart) {
+				a_state = Quoted;
+				a_quoted = true;
+			} else {
+				a_chunk.text += c;
+				a_state = Unquoted;
+			}
+		}
+	}
+}
+
+/*!
+ * \brief Schließt das aktuelle Feld ab
+ */
+void CsvParser::m_endField() {
+	a_chunk.fieldEnds << a_chunk.text.size();
+	a_state = FieldStart;
+}
+
+/*!
+ * \brief Schließt die aktuelle Zeile ab
+ *
+ * Bei LF als Zeilentrenner wird ein CR am Ende eines Feldes ohne Anführungszeichen entfernt (CRLF), bei CR
+ * als Zeilentrenner ein direkt folgendes LF übersprungen. Leere Zeilen werden verworfen; eine Zeile, die nur aus
+ * "" besteht, bleibt als Zeile mit einem leeren Feld erhalten, damit sie beim Import als fehlerhaft gemeldet
+ * wird. Ist genug Text zusammengekommen, werden die fertigen Zeilen gemeldet.
+ */
+void CsvParser::m_endRow() {
+	int rowStart = a_chunk.rowEnds.isEmpty() ? 0 : a_chunk.rowEnds.last();
+	int fieldStart = a_chunk.fieldEnds.isEmpty() ? 0 : a_chunk.fieldEnds.last();
+
+	if (a_rowSeparator == '\n' && a_state == Unquoted && a_chunk.text.size() > fieldStart
+			&& a_chunk.text.endsWith('\r'))
+		a_chunk.text.chop(1);
+	bool empty = a_chunk.fieldEnds.size() == rowStart && a_chunk.text.size() == fieldStart && !a_quoted;
+	if (a_rowSeparator == '\r')
+		a_skipLf = true;
+	a_state = FieldStart;
+	a_quoted = false;
+	if (empty)
+		return;
+
+	m_endField();
+	a_chunk.rowEnds << a_chunk.fieldEnds.size();
+	a_chunk.columnCount = qMax(a_chunk.columnCount, a_chunk.fieldEnds.size() - rowStart);
+	if (a_chunk.text.size() >= a_chunkSize)
+		m_flush();
+}
+
+/*!
+ * \brief Meldet die fertigen Zeilen
+ *
+ * Wird nur an Zeilengrenzen aufgerufen, es bleibt also keine angefangene Zeile übrig.
+ */
+void CsvParser::m_flush() {
+	if (a_chunk.rowEnds.isEmpty())
+		return;
+	emit parsed(a_ticket, a_chunk);
+	a_chunk.clear();
+}
@@ -0,0 +1,84 @@
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+#include <QMetaType>
+
+/*!
+ * \brief Kompakte Darstellung eingelesener CSV-Zeilen
+ *
+ * Die Inhalte aller Felder stehen ohne Trennzeichen hintereinander in einem einzigen Puffer. Zu jedem Feld
+ * wird nur seine Endposition und zu jeder Zeile nur der Index hinter ihrem letzten Feld gespeichert.
+ */
+struct CsvTable {
+	QString text;                            ///< Inhalte aller Felder hintereinander
+	QVector<int> fieldEnds;                  ///< Zuordnung Feld->Endposition in text
+	QVector<int> rowEnds;                    ///< Zuordnung Zeile->Index hinter dem letzten Feld in fieldEnds
+	int columnCount;                         ///< Höchste Anzahl an Feldern pro Zeile
+
+	CsvTable() : columnCount(0) {}
+	int rowCount() const {return rowEnds.size();}
+	int fieldCount(int row) const;
+	QString field(int row, int column) const;
+	void append(const CsvTable &other);
+	void clear();
+	void squeeze();
+};
+
+Q_DECLARE_METATYPE(CsvTable)
+
+/*!
+ * \brief Liest eine CSV-Datei stückweise ein
+ *
+ * Lebt im Thread des ImportModels. Die Datei wird in Blöcken von a_blockSize Bytes gelesen, dekodiert
+ * (UTF-8 oder, falls die Datei kein gültiges UTF-8 ist, Latin-1/Windows-1252) und zeichenweise zerlegt.
+ * Felder dürfen in Anführungszeichen stehen und dann auch Trennzeichen und verdoppelte Anführungszeichen
+ * enthalten; CRLF-Zeilenenden werden in beiden Einstellungen des Zeilentrenners erkannt. Fertige Zeilen
+ * werden in Paketen über parsed() gemeldet, damit die Vorschau schon während des Einlesens gefüllt wird.
+ */
+class CsvParser : public QObject {
+	Q_OBJECT
+private:
+	/*!
+	 * \brief Zustand innerhalb des aktuellen Feldes
+	 */
+	enum State {
+		FieldStart,                      ///< Am Anfang eines Feldes
+		Unquoted,                        ///< In einem Feld ohne Anführungszeichen
+		Quoted,                          ///< In einem Feld in Anführungszeichen
+		QuoteInQuoted                    ///< Nach einem Anführungszeichen in einem Feld in Anführungszeichen
+	};
+
+	static constexpr int a_blockSize = 64 * 1024; ///< Größe der gelesenen Blöcke in Bytes
+	static constexpr int a_chunkSize = 64 * 1024; ///< Textmenge, ab der die fertigen Zeilen gemeldet werden
+	QAtomicInt a_current;                    ///< Nummer des aktuellen Auftrags (0: keiner)
+	int a_ticket;                            ///< Nummer des gerade bearbeiteten Auftrags
+	QChar a_rowSeparator;                    ///< Zeilentrenner
+	QChar a_colSeparator;                    ///< Feldtrenner
+	State a_state;                           ///< Zustand innerhalb des aktuellen Feldes
+	bool a_skipLf;                           ///< Wird ein LF direkt nach einem CR übersprungen?
+	bool a_quoted;                           ///< Stand in der aktuellen Zeile schon ein Feld in Anführungszeichen?
+	CsvTable a_chunk;                        ///< Noch nicht gemeldete Zeilen inkl. der angefangenen Zeile
+
+	void m_feed(const QString &text);
+	void m_endField();
+	void m_endRow();
+	void m_flush();
+
+public:
+	CsvParser() : QObject(0), a_ticket(0), a_state(FieldStart), a_skipLf(false), a_quoted(false) {}
+	void setCurrent(int ticket) {a_current.store(ticket);}
+
+public slots:
+	void parse(int ticket, QString fileName, QChar rowSeparator, QChar colSeparator);
+
+signals:
+	void parsed(int ticket, CsvTable chunk);
+	void restarted(int ticket);
+	void finished(int ticket, QString error);
+};
+
+#endif
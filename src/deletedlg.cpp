@@ -12,7 +12,7 @@
  * \see BaseDialog(), m_createInterface()
  */
 DeleteDialog::DeleteDialog(bool endOfTerm, QWidget *parent, QSqlRecord record):
-	BaseDialog(endOfTerm, parent) {
+	BaseDialog(endOfTerm, parent), a_trace("dialog", "DeleteDialog") {
 	m_createInterface(record);
 }
 
@@ -61,14 +61,10 @@ void DeleteDialog::m_setInitialValues(QSqlRecord record) {
 }
 
 /*!
- * \brief Überprüft Eingaben und führt SQL-Abfrage aus
+ * \brief Überprüft Eingaben und bucht die Rückgabe
  *
- * Im Normalen Modus werden zuerst bei allen Ausleihe-Datensätzen dieses Schülers/Lehrers und
- * des entsprechenden Buchs die Anzahl dekrementiert. Anschließend werden alle Ausleihdatensätze
- * gelöscht deren Anzahl 0 ist.
- *
- * Im Schuljahresendmodus werden alle BTausch-Datensätze mit der betreffenden Schüler-ID
- * und ISBN gelöscht.
+ * Die Rückgabe wird in einer Transaktion gebucht (siehe m_returnXAusleihe() und m_returnBTausch()).
+ * Bücher, die gar nicht ausgeliehen waren, werden anschließend gemeldet.
  */
 void DeleteDialog::accept() {
 	if (a_id == -1) {
@@ -80,30 +76,134 @@ void DeleteDialog::accept() {
 		QMessageBox::warning(this, tr("Fehlende Angaben"), tr("Keine Bücher ausgewählt!"));
 		return;
 	}
-	if (!a_eot) {
-		a_q.prepare(tr("UPDATE %1ausleihe SET anz = anz - 1 WHERE %1id = :lid AND bid = :bid")
-			  .arg(a_student->isChecked() ? "s" : "l"));
-		for (int i = 0; i < a_numIsbns; ++i) {
-			if (!a_isbn[i].isEmpty()) {
-				a_q.bindValue(":lid", a_id);
-				a_q.bindValue(":bid", a_isbn[i]);
-				if (!::exec(a_q)) return;
-			}
+	if (m_lookupsPending())
+		return;
+
+	QStringList notLent;
+	QSqlDatabase db = QSqlDatabase::database();
+	if (!db.transaction()) {
+		sqlError(db.lastError(), "START TRANSACTION");
+		return;
+	}
+	if (!(a_eot ? m_returnBTausch(&notLent) : m_returnXAusleihe(&notLent))) {
+		db.rollback();
+		a_changed.clear();
+		return;
+	}
+	if (!db.commit()) {
+		sqlError(db.lastError(), "COMMIT");
+		db.rollback();
+		a_changed.clear();
+		return;
+	}
+	if (!notLent.isEmpty())
+		QMessageBox::warning(this, tr("Nicht ausgeliehen"), tr("Folgende Bücher waren nicht ausgeliehen:\n%1")
+				     .arg(notLent.join("\n")));
+	QDialog::accept();
+}
+
+/*!
+ * \brief Bucht die Rückgabe in lausleihe oder sausleihe
+ * \param notLent Nimmt die Titel der Bücher auf, die nicht (oft genug) ausgeliehen waren
+ * \return true - Kein Datenbankfehler
+ *
+ * Es werden nur die Datensätze dieses Schülers/Lehrers und der eingescannten Bücher gelesen (und gesperrt).
+ * Für jedes eingescannte Exemplar wird die Anzahl dekrementiert; Datensätze, deren Anzahl dabei 0 erreicht,
+ * werden mit einem DELETE, alle anderen mit einem UPDATE geändert. Muss innerhalb einer Transaktion
+ * aufgerufen werden.
+ */
+bool DeleteDialog::m_returnXAusleihe(QStringList *notLent) {
+	QString x = a_student->isChecked() ? "s" : "l";
+	QList<int> fields = m_scannedFields();
+	QHash<QString, int> count;
+	QStringList exhausted, remaining;
+
+	a_q.prepare(tr("SELECT `bid`, `anz` FROM `%1ausleihe` WHERE `%1id` = :lid AND `bid` IN (%2) FOR UPDATE")
+		    .arg(x).arg(placeholders(":bid", fields.size())));
+	a_q.bindValue(":lid", a_id);
+	for (int n = 0; n < fields.size(); ++n)
+		a_q.bindValue(QString(":bid%1").arg(n), a_isbn[fields[n]]);
+	if (!::exec(a_q))
+		return false;
+	while (a_q.next())
+		count.insert(a_q.value(0).toString(), a_q.value(1).toInt());
+
+	foreach (int i, fields) {
+		if (count.value(a_isbn[i]) <= 0) {
+			*notLent << a_title[i]->text();
+			continue;
 		}
-		if (!a_q.exec(tr("DELETE FROM %1ausleihe WHERE anz <= 0").arg(a_student->isChecked()
-									      ? "s" : "l"))) {
-			sqlError(a_q);
-			return;
+		--count[a_isbn[i]];
+		a_changed.append(qMakePair(a_id, a_isbn[i]));
+	}
+	for (QHash<QString, int>::const_iterator i = count.constBegin(); i != count.constEnd(); ++i)
+		(i.value() <= 0 ? exhausted : remaining) << i.key();
+
+	if (!exhausted.isEmpty()) {
+		a_q.prepare(tr("DELETE FROM `%1ausleihe` WHERE `%1id` = :lid AND `bid` IN (%2)")
+			    .arg(x).arg(placeholders(":bid", exhausted.size())));
+		a_q.bindValue(":lid", a_id);
+		for (int n = 0; n < exhausted.size(); ++n)
+			a_q.bindValue(QString(":bid%1").arg(n), exhausted[n]);
+		if (!::exec(a_q))
+			return false;
+	}
+	if (!remaining.isEmpty()) {
+		QString cases;
+		for (int n = 0; n < remaining.size(); ++n)
+			cases += QString(" WHEN :bid%1 THEN :anz%1").arg(n);
+		a_q.prepare(tr("UPDATE `%1ausleihe` SET `anz` = CASE `bid`%2 END WHERE `%1id` = :lid AND `bid` IN (%3)")
+			    .arg(x).arg(cases).arg(placeholders(":in", remaining.size())));
+		a_q.bindValue(":lid", a_id);
+		for (int n = 0; n < remaining.size(); ++n) {
+			a_q.bindValue(QString(":bid%1").arg(n), remaining[n]);
+			a_q.bindValue(QString(":anz%1").arg(n), count[remaining[n]]);
+			a_q.bindValue(QString(":in%1").arg(n), remaining[n]);
 		}
-	} else {
-		a_q.prepare("DELETE FROM `btausch` WHERE `sid` = :sid AND `bid` = :bid");
-		for (int i = 0; i < a_numIsbns; ++i) {
-			if (!a_isbn[i].isEmpty()) {
-				a_q.bindValue(":sid", a_id);
-				a_q.bindValue(":bid", a_isbn[i]);
-				if (!::exec(a_q)) return;
-			}
+		if (!::exec(a_q))
+			return false;
+	}
+	return true;
+}
+
+/*!
+ * \brief Bucht die Rückgabe im Rahmen des Büchertauschs
+ * \param notLent Nimmt die Titel der Bücher auf, die nicht in btausch eingetragen waren
+ * \return true - Kein Datenbankfehler
+ *
+ * Alle BTausch-Datensätze mit der betreffenden Schüler-ID und den eingescannten ISBNs werden mit einem
+ * DELETE gelöscht. Muss innerhalb einer Transaktion aufgerufen werden.
+ */
+bool DeleteDialog::m_returnBTausch(QStringList *notLent) {
+	QList<int> fields = m_scannedFields();
+	QSet<QString> present;
+	QStringList bids;
+
+	a_q.prepare(tr("SELECT `bid` FROM `btausch` WHERE `sid` = :sid AND `bid` IN (%1) FOR UPDATE")
+		    .arg(placeholders(":bid", fields.size())));
+	a_q.bindValue(":sid", a_id);
+	for (int n = 0; n < fields.size(); ++n)
+		a_q.bindValue(QString(":bid%1").arg(n), a_isbn[fields[n]]);
+	if (!::exec(a_q))
+		return false;
+	while (a_q.next())
+		present.insert(a_q.value(0).toString());
+
+	foreach (int i, fields) {
+		if (!present.remove(a_isbn[i])) {
+			*notLent << a_title[i]->text();
+			continue;
 		}
+		bids << a_isbn[i];
+		a_changed.append(qMakePair(a_id, a_isbn[i]));
 	}
-	QDialog::accept();
+	if (bids.isEmpty())
+		return true;
+
+	a_q.prepare(tr("DELETE FROM `btausch` WHERE `sid` = :sid AND `bid` IN (%1)")
+		    .arg(placeholders(":bid", bids.size())));
+	a_q.bindValue(":sid", a_id);
+	for (int n = 0; n < bids.size(); ++n)
+		a_q.bindValue(QString(":bid%1").arg(n), bids[n]);
+	return ::exec(a_q);
 }
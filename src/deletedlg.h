@@ -12,8 +12,12 @@ public:
 	DeleteDialog(bool endOfTerm, QWidget *parent = 0, QSqlRecord record = QSqlRecord());
 
 private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
+
 	void m_alignComponents();
 	void m_setInitialValues(QSqlRecord record);
+	bool m_returnXAusleihe(QStringList *notLent);
+	bool m_returnBTausch(QStringList *notLent);
 
 public slots:
 	void accept();
@@ -0,0 +1,113 @@
+#include "diagnosticsdlg.h"
+#include "watchdog.h"
+#include "querystats.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFontDatabase>
+#include <algorithm>
+
+/*!
+ * \brief Konstruktor von DiagnosticsDialog
+ * \param parent Eltern-Widget
+ * \see m_createComponents(), m_alignComponents, m_setInitialValues(), m_connectComponents()
+ */
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) : QDialog(parent), a_trace("dialog", "DiagnosticsDialog") {
+	m_createComponents();
+	m_alignComponents();
+	m_setInitialValues();
+	m_connectComponents();
+}
+
+/*!
+ * \brief Erstellt die Komponenten
+ */
+void DiagnosticsDialog::m_createComponents() {
+	a_buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+	a_update = a_buttonBox->addButton(tr("Aktualisieren"), QDialogButtonBox::ActionRole);
+	a_tabWidget = new QTabWidget;
+	a_summary = new QLabel;
+	a_stalls = new QTableWidget(0, 4);
+	a_queries = new QPlainTextEdit;
+}
+
+/*!
+ * \brief Ordnet die Komponenten in Layouts an
+ */
+void DiagnosticsDialog::m_alignComponents() {
+	QWidget *stalls = new QWidget;
+	QVBoxLayout *a = new QVBoxLayout;
+	a->addWidget(a_summary);
+	a->addWidget(a_stalls);
+	stalls->setLayout(a);
+
+	a_tabWidget->addTab(stalls, tr("Hänger"));
+	a_tabWidget->addTab(a_queries, tr("Statements"));
+
+	QVBoxLayout *layout = new QVBoxLayout;
+	layout->addWidget(a_tabWidget);
+	layout->addWidget(a_buttonBox);
+	setLayout(layout);
+}
+
+/*!
+ * \brief Setzt die Anfangswerte
+ */
+void DiagnosticsDialog::m_setInitialValues() {
+	setWindowTitle(tr("Diagnose"));
+	resize(800, 500);
+	a_stalls->setHorizontalHeaderLabels(QStringList() << tr("Bereich") << tr("Anzahl") << tr("Gesamt (ms)")
+					    << tr("Max. (ms)"));
+	a_stalls->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+	a_stalls->verticalHeader()->hide();
+	a_stalls->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	a_stalls->setSelectionBehavior(QAbstractItemView::SelectRows);
+	a_queries->setReadOnly(true);
+	a_queries->setLineWrapMode(QPlainTextEdit::NoWrap);
+	a_queries->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	refresh();
+}
+
+/*!
+ * \brief Verbindet die Komponenten mit den Slots
+ */
+void DiagnosticsDialog::m_connectComponents() {
+	connect(a_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+	connect(a_update, SIGNAL(clicked()), this, SLOT(refresh()));
+}
+
+/*!
+ * \brief Liest die Zähler von Watchdog und QueryStats neu ein
+ *
+ * Die Bereiche werden nach der Gesamtdauer ihrer Hänger absteigend sortiert.
+ */
+void DiagnosticsDialog::refresh() {
+	Watchdog *watchdog = Watchdog::instance();
+	a_stalls->setRowCount(0);
+	if (!watchdog) {
+		a_summary->setText(tr("Der Watchdog ist ausgeschaltet (diag/stall-ms = 0)."));
+	} else {
+		a_summary->setText(tr("%1 Hänger über %2 ms, zusammen %3 s")
+				   .arg(watchdog->stalls()).arg(watchdog->thresholdMs())
+				   .arg(watchdog->stallTotal() / 1e9, 0, 'f', 1));
+		QHash<QString, Watchdog::Counter> counters = watchdog->counters();
+		QStringList scopes = counters.keys();
+		std::sort(scopes.begin(), scopes.end(), [&counters](const QString &a, const QString &b) {
+			return counters.value(a).total > counters.value(b).total;
+		});
+		a_stalls->setRowCount(scopes.size());
+		for (int i = 0; i < scopes.size(); ++i) {
+			const Watchdog::Counter &c = counters[scopes[i]];
+			a_stalls->setItem(i, 0, new QTableWidgetItem(scopes[i]));
+			a_stalls->setItem(i, 1, new QTableWidgetItem(QString::number(c.count)));
+			a_stalls->setItem(i, 2, new QTableWidgetItem(QString::number(c.total / 1000000)));
+			a_stalls->setItem(i, 3, new QTableWidgetItem(QString::number(c.max / 1000000)));
+			for (int j = 1; j < 4; ++j)
+				a_stalls->item(i, j)->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+		}
+	}
+	a_stalls->resizeColumnsToContents();
+
+	QueryStats *stats = QueryStats::instance();
+	a_queries->setPlainText(stats ? stats->report() : tr("Keine Messungen vorhanden."));
+}
@@ -0,0 +1,39 @@
+#ifndef DIAGNOSTICSDLG_H
+#define DIAGNOSTICSDLG_H
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include "tracer.h"
+
+/*!
+ * \brief Zeigt die Hänger des GUI-Threads (Watchdog) und die Laufzeiten der Statements (QueryStats) an
+ */
+class DiagnosticsDialog : public QDialog {
+	Q_OBJECT
+private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
+	QDialogButtonBox *a_buttonBox;           ///< Schließen
+	QPushButton *a_update;                   ///< Liest die Zähler neu ein
+	QTabWidget *a_tabWidget;                 ///< Trennt Hänger und Statements
+	QLabel *a_summary;                       ///< Zusammenfassung der Hänger
+	QTableWidget *a_stalls;                  ///< Hänger pro Bereich
+	QPlainTextEdit *a_queries;               ///< Bericht von QueryStats
+
+	void m_createComponents();
+	void m_alignComponents();
+	void m_setInitialValues();
+	void m_connectComponents();
+
+public:
+	DiagnosticsDialog(QWidget *parent = 0);
+
+private slots:
+	void refresh();
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "executor.h"
+#include "querystats.h"
+#include "tracer.h"
+#include <QMutexLocker>
+
+QueryExecutor *QueryExecutor::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von QueryWorker
+ * \param executor Auftraggeber
+ * \param db Verbindung, deren Einstellungen übernommen werden
+ *
+ * Es werden nur die Verbindungsdaten kopiert, die Verbindung selbst wird erst im Worker-Thread
+ * angelegt, da eine Verbindung nur in dem Thread benutzt werden darf, der sie erzeugt hat.
+ */
+QueryWorker::QueryWorker(QueryExecutor *executor, const QSqlDatabase &db) : QObject(0),
+	a_executor(executor) {
+	a_connection = QString("worker@%1").arg(quintptr(this), 0, 16);
+	a_driver = db.driverName();
+	a_host = db.hostName();
+	a_name = db.databaseName();
+	a_user = db.userName();
+	a_password = db.password();
+	a_options = db.connectOptions();
+	a_port = db.port();
+}
+
+/*!
+ * \brief Destruktor von QueryWorker
+ *
+ * Schließt die eigene Verbindung und meldet sie ab.
+ */
+QueryWorker::~QueryWorker() {
+	if (!QSqlDatabase::contains(a_connection))
+		return;
+	{
+		QSqlDatabase db = QSqlDatabase::database(a_connection, false);
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(a_connection);
+}
+
+/*!
+ * \brief Öffnet bei Bedarf die eigene Verbindung
+ * \param error Nimmt ggf. den Fehler auf
+ * \return true - Verbindung ist offen
+ */
+bool QueryWorker::m_open(QSqlError *error) {
+	QSqlDatabase db;
+	if (QSqlDatabase::contains(a_connection)) {
+		db = QSqlDatabase::database(a_connection, false);
+	} else {
+		db = QSqlDatabase::addDatabase(a_driver, a_connection);
+		db.setHostName(a_host);
+		db.setPort(a_port);
+		db.setDatabaseName(a_name);
+		db.setUserName(a_user);
+		db.setPassword(a_password);
+		db.setConnectOptions(a_options);
+	}
+	if (db.isOpen() || db.open())
+		return true;
+	*error = db.lastError();
+	return false;
+}
+
+/*!
+ * \brief Führt einen Auftrag aus
+ * \param ticket Nummer des Auftrags
+ * \param channel Kanal des Auftrags
+ * \param statements Auszuführende Statements
+ *
+ * Ist der Auftrag bereits veraltet, wird er nur als verworfen zurückgemeldet. Sonst werden die Statements
+ * nacheinander ausgeführt, bis eines fehlschlägt. Die Ergebnisse werden komplett eingelesen, damit der
+ * GUI-Thread keine Datenbankzugriffe mehr benötigt.
+ */
+void QueryWorker::run(int ticket, QString channel, QList<QueryRequest> statements) {
+	QueryResult result;
+	result.ticket = ticket;
+	result.channel = channel;
+	TraceScope trace("executor", channel.section('@', 0, 0));
+
+	if (!a_executor->isCurrent(channel, ticket)) {
+		result.cancelled = true;
+		emit finished(result);
+		return;
+	}
+	if (!m_open(&result.error)) {
+		emit finished(result);
+		return;
+	}
+
+	TimedQuery q(QSqlDatabase::database(a_connection));
+	foreach (const QueryRequest &statement, statements) {
+		QueryResultSet set;
+		q.setForwardOnly(true);
+		if (q.prepare(statement.sql)) {
+			for (QVariantMap::const_iterator i = statement.values.constBegin(); i != statement.values.constEnd(); ++i)
+				q.bindValue(i.key(), i.value());
+		}
+		if (!q.exec()) {
+			result.error = q.lastError();
+			result.failedQuery = statement.sql;
+			break;
+		}
+		if (q.isSelect()) {
+			set.columns = q.record();
+			set.columns.clearValues();
+			int columns = set.columns.count();
+			if (q.size() > 0)
+				set.rows.reserve(q.size());
+			while (q.next()) {
+				QVariantList row;
+				row.reserve(columns);
+				for (int i = 0; i < columns; ++i)
+					row << q.value(i);
+				set.rows.append(row);
+			}
+		}
+		set.numRowsAffected = q.numRowsAffected();
+		result.sets.append(set);
+	}
+	emit finished(result);
+}
+
+/*!
+ * \brief Konstruktor von QueryExecutor
+ * \param parent Elternobjekt
+ *
+ * Registriert die Datentypen für die Signale zwischen den Threads, erzeugt den Worker mit den
+ * Verbindungsdaten der Standardverbindung und startet dessen Thread.
+ */
+QueryExecutor::QueryExecutor(QObject *parent) : QObject(parent), a_nextTicket(1), a_pending(0) {
+	qRegisterMetaType<QueryRequest>("QueryRequest");
+	qRegisterMetaType<QList<QueryRequest>>("QList<QueryRequest>");
+	qRegisterMetaType<QueryResult>("QueryResult");
+	s_instance = this;
+
+	a_thread.setObjectName("QueryExecutor");
+	a_worker = new QueryWorker(this, QSqlDatabase::database());
+	a_worker->moveToThread(&a_thread);
+	connect(&a_thread, SIGNAL(finished()), a_worker, SLOT(deleteLater()));
+	connect(this, SIGNAL(requested(int,QString,QList<QueryRequest>)),
+		a_worker, SLOT(run(int,QString,QList<QueryRequest>)));
+	connect(a_worker, SIGNAL(finished(QueryResult)), this, SLOT(deliver(QueryResult)));
+	a_thread.start();
+}
+
+/*!
+ * \brief Destruktor von QueryExecutor
+ *
+ * Beendet den Worker-Thread und wartet auf ihn.
+ */
+QueryExecutor::~QueryExecutor() {
+	a_thread.quit();
+	a_thread.wait();
+	if (s_instance == this)
+		s_instance = 0;
+}
+
+/*!
+ * \brief Gibt die Instanz der Anwendung zurück
+ * \return Der in main() erzeugte QueryExecutor
+ */
+QueryExecutor *QueryExecutor::instance() {
+	Q_ASSERT(s_instance);
+	return s_instance;
+}
+
+/*!
+ * \brief Erzeugt einen Kanalnamen, der nur für ein Objekt gilt
+ * \param owner Objekt, dem der Kanal gehört
+ * \param name Name des Kanals innerhalb des Objekts
+ * \return Eindeutiger Kanalname
+ */
+QString QueryExecutor::channel(const QObject *owner, QString name) {
+	return QString("%1@%2").arg(name).arg(quintptr(owner), 0, 16);
+}
+
+/*!
+ * \brief Stellt einen Auftrag
+ * \param channel Kanal; ältere Aufträge desselben Kanals werden verworfen
+ * \param statements Auszuführende Statements
+ * \return Nummer des Auftrags, anhand derer das Ergebnis in finished() erkannt wird
+ */
+int QueryExecutor::submit(QString channel, QList<QueryRequest> statements) {
+	int ticket;
+	{
+		QMutexLocker locker(&a_mutex);
+		ticket = a_nextTicket++;
+		a_latest[channel] = ticket;
+	}
+	if (a_pending++ == 0)
+		emit busyChanged(true);
+	Tracer::asyncBegin("executor", channel.section('@', 0, 0), ticket);
+	emit requested(ticket, channel, statements);
+	return ticket;
+}
+
+/*!
+ * \brief Stellt einen Auftrag mit nur einem Statement
+ * \see submit()
+ */
+int QueryExecutor::submit(QString channel, QueryRequest statement) {
+	return submit(channel, QList<QueryRequest>() << statement);
+}
+
+/*!
+ * \brief Verwirft alle noch ausstehenden Aufträge eines Kanals
+ * \param channel Kanal
+ */
+void QueryExecutor::cancel(QString channel) {
+	QMutexLocker locker(&a_mutex);
+	a_latest.remove(channel);
+}
+
+/*!
+ * \brief Prüft, ob ein Auftrag noch der neueste seines Kanals ist
+ * \param channel Kanal
+ * \param ticket Nummer des Auftrags
+ * \return true - Auftrag ist noch gültig
+ *
+ * Wird sowohl vom Worker-Thread als auch vom GUI-Thread aufgerufen.
+ */
+bool QueryExecutor::isCurrent(QString channel, int ticket) const {
+	QMutexLocker locker(&a_mutex);
+	return a_latest.value(channel) == ticket;
+}
+
+/*!
+ * \brief Nimmt die Ergebnisse des Workers im GUI-Thread entgegen
+ * \param result Ergebnis eines Auftrags
+ *
+ * Veraltete oder verworfene Ergebnisse werden nicht weitergegeben. Ist der Auftrag der neueste seines Kanals,
+ * wird der Kanal aus a_latest entfernt; verdrängte Aufträge hat submit() schon überschrieben, sodass a_latest
+ * nur Kanäle mit ausstehenden Aufträgen enthält.
+ */
+void QueryExecutor::deliver(QueryResult result) {
+	if (--a_pending == 0)
+		emit busyChanged(false);
+	Tracer::asyncEnd("executor", result.channel.section('@', 0, 0), result.ticket);
+	bool current;
+	{
+		QMutexLocker locker(&a_mutex);
+		current = a_latest.value(result.channel) == result.ticket;
+		if (current)
+			a_latest.remove(result.channel);
+	}
+	if (result.cancelled || !current)
+		return;
+	emit finished(result);
+}
@@ -0,0 +1,127 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QVariant>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlRecord>
+
+/*!
+ * \brief Ein einzelnes Statement eines Auftrags an den QueryExecutor
+ */
+struct QueryRequest {
+	QString sql;                             ///< Statement mit benannten Platzhaltern
+	QVariantMap values;                      ///< Zuordnung Platzhalter->Wert
+
+	QueryRequest(QString s = QString(), QVariantMap v = QVariantMap()) : sql(s), values(v) {}
+};
+
+/*!
+ * \brief Die Ergebnismenge eines einzelnen Statements
+ */
+struct QueryResultSet {
+	QSqlRecord columns;                      ///< Spaltenbeschreibung (ohne Werte)
+	QVector<QVariantList> rows;              ///< Die einzelnen Datensätze
+	int numRowsAffected;                     ///< Anzahl der veränderten Datensätze
+
+	QueryResultSet() : numRowsAffected(-1) {}
+};
+
+/*!
+ * \brief Das Ergebnis eines Auftrags an den QueryExecutor
+ */
+struct QueryResult {
+	int ticket;                              ///< Nummer des Auftrags
+	QString channel;                         ///< Kanal, über den der Auftrag gestellt wurde
+	bool cancelled;                          ///< Wurde der Auftrag verworfen, bevor er ausgeführt wurde?
+	QList<QueryResultSet> sets;              ///< Eine Ergebnismenge pro Statement
+	QSqlError error;                         ///< Ggf. aufgetretener Fehler
+	QString failedQuery;                     ///< Statement, bei dem der Fehler auftrat
+
+	QueryResult() : ticket(0), cancelled(false) {}
+	bool ok() const {return !cancelled && !error.isValid();}
+};
+
+Q_DECLARE_METATYPE(QueryRequest)
+Q_DECLARE_METATYPE(QList<QueryRequest>)
+Q_DECLARE_METATYPE(QueryResult)
+
+class QueryExecutor;
+
+/*!
+ * \brief Führt die Aufträge des QueryExecutors in dessen Thread aus
+ *
+ * Der Worker besitzt eine eigene Datenbankverbindung, die erst im Worker-Thread geöffnet wird.
+ */
+class QueryWorker : public QObject {
+	Q_OBJECT
+private:
+	QueryExecutor *a_executor;               ///< Auftraggeber (für die Prüfung auf veraltete Aufträge)
+	QString a_connection;                    ///< Name der eigenen Verbindung
+	QString a_driver;                        ///< Datenbanktreiber
+	QString a_host;                          ///< Adresse des Datenbankservers
+	QString a_name;                          ///< Name der Datenbank
+	QString a_user;                          ///< Benutzername
+	QString a_password;                      ///< Passwort
+	QString a_options;                       ///< Verbindungsoptionen
+	int a_port;                              ///< Port des Datenbankservers
+
+	bool m_open(QSqlError *error);
+
+public:
+	QueryWorker(QueryExecutor *executor, const QSqlDatabase &db);
+	~QueryWorker();
+
+public slots:
+	void run(int ticket, QString channel, QList<QueryRequest> statements);
+
+signals:
+	void finished(QueryResult result);
+};
+
+/*!
+ * \brief Führt SQL-Abfragen asynchron in einem eigenen Thread aus
+ *
+ * Aufträge werden über einen Kanal gestellt. Ein neuer Auftrag im selben Kanal macht alle älteren
+ * Aufträge dieses Kanals ungültig: Sie werden nicht mehr ausgeführt bzw. ihre Ergebnisse nicht mehr
+ * ausgeliefert. So wird z.B. beim schnellen Wechsel der Klasse nur die letzte Auswahl geladen.
+ */
+class QueryExecutor : public QObject {
+	Q_OBJECT
+private:
+	static QueryExecutor *s_instance;        ///< Die Instanz der Anwendung
+	QThread a_thread;                        ///< Thread, in dem a_worker lebt
+	QueryWorker *a_worker;                   ///< Führt die Aufträge aus
+	mutable QMutex a_mutex;                  ///< Schützt a_latest
+	QHash<QString, int> a_latest;            ///< Zuordnung Kanal->neuester ausstehender Auftrag
+	int a_nextTicket;                        ///< Nummer des nächsten Auftrags
+	int a_pending;                           ///< Anzahl der noch nicht zurückgemeldeten Aufträge
+
+public:
+	QueryExecutor(QObject *parent = 0);
+	~QueryExecutor();
+	static QueryExecutor *instance();
+	static QString channel(const QObject *owner, QString name);
+
+	int submit(QString channel, QList<QueryRequest> statements);
+	int submit(QString channel, QueryRequest statement);
+	void cancel(QString channel);
+	bool isCurrent(QString channel, int ticket) const;
+	bool isBusy() const {return a_pending > 0;}
+
+private slots:
+	void deliver(QueryResult result);
+
+signals:
+	void requested(int ticket, QString channel, QList<QueryRequest> statements);
+	void finished(QueryResult result);
+	void busyChanged(bool busy);
+};
+
+#endif
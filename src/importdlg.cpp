@@ -9,10 +9,30 @@
  * \brief Konstruktor von ImportModel
  * \param parent Elternobjekt
  *
- * Abgesehen vom Aufruf des Elternkonstruktors wird hier nur a_columnCount auf 0 gesetzt
+ * Erzeugt den CsvParser und startet dessen Thread.
  */
-ImportModel::ImportModel(QObject *parent) : QAbstractTableModel(parent) {
-	a_columnCount = 0;
+ImportModel::ImportModel(QObject *parent) : QAbstractTableModel(parent), a_ticket(0), a_nextTicket(1),
+	a_cache(64 * 1024 * 1024) {
+	qRegisterMetaType<CsvTable>("CsvTable");
+	a_parser = new CsvParser;
+	a_parser->moveToThread(&a_thread);
+	connect(&a_thread, SIGNAL(finished()), a_parser, SLOT(deleteLater()));
+	connect(this, SIGNAL(requested(int,QString,QChar,QChar)), a_parser, SLOT(parse(int,QString,QChar,QChar)));
+	connect(a_parser, SIGNAL(parsed(int,CsvTable)), this, SLOT(appendRows(int,CsvTable)));
+	connect(a_parser, SIGNAL(restarted(int)), this, SLOT(clearRows(int)));
+	connect(a_parser, SIGNAL(finished(int,QString)), this, SLOT(parseFinished(int,QString)));
+	a_thread.start();
+}
+
+/*!
+ * \brief Destruktor von ImportModel
+ *
+ * Bricht einen laufenden Leseauftrag ab und wartet auf den Thread.
+ */
+ImportModel::~ImportModel() {
+	a_parser->setCurrent(0);
+	a_thread.quit();
+	a_thread.wait();
 }
 
 /*!
@@ -21,30 +41,101 @@ ImportModel::ImportModel(QObject *parent) : QAbstractTableModel(parent) {
  * \param rowSeparator Zeichen, das Datensätze voneinander trennt
  * \param colSeparator Zeichen, das die Felder voneinander trennt
  *
- * Die gesamte Datei wird ausgelesen und mithilfe von QStringList::split() entlang der Zeilen aufgetrennt.
- * Danach wird über die Zeilen iteriert und dabei dann jeder Eintrag an den Feldtrennern getrennt und die höchste
- * Anzahl an Feldern pro Datensatz in a_columnCount gespeichert.
+ * Werden die Daten zu genau dieser Datei (inkl. Änderungszeit und Größe) und diesen Trennzeichen schon
+ * angezeigt oder gelesen, passiert nichts. Liegen sie im Zwischenspeicher, werden sie von dort übernommen.
+ * Sonst werden die bisherigen Daten verworfen und die Datei im Hintergrund eingelesen; ein noch laufender
+ * Leseauftrag wird dabei abgebrochen. Sind die Daten vollständig, wird loaded() emittiert.
  */
 void ImportModel::setFileName(QString fileName, QChar rowSeparator, QChar colSeparator) {
 	if (fileName.isEmpty())
 		return;
-	QFile *f = new QFile(fileName);
-	f->open(QFile::ReadOnly);
-	QTextStream stream(f);
-	QStringList str;
-	a_columnCount = 0;
+	QString key = m_key(fileName, rowSeparator, colSeparator);
+	if (key == a_key)
+		return;
+	a_key = key;
+
+	beginResetModel();
+	if (a_cache.contains(key))
+		a_data = *a_cache.object(key);
+	else
+		a_data.clear();
+	endResetModel();
+	if (a_cache.contains(key)) {
+		a_ticket = 0;
+		a_parser->setCurrent(0);
+		emit loaded();
+		return;
+	}
+
+	a_ticket = a_nextTicket++;
+	a_parser->setCurrent(a_ticket);
+	emit requested(a_ticket, fileName, rowSeparator, colSeparator);
+}
+
+/*!
+ * \brief Hängt eingelesene Zeilen an
+ * \param ticket Nummer des Leseauftrags
+ * \param chunk Die Zeilen
+ */
+void ImportModel::appendRows(int ticket, CsvTable chunk) {
+	if (ticket != a_ticket || chunk.rowCount() == 0)
+		return;
+	if (chunk.columnCount > a_data.columnCount) {
+		beginInsertColumns(QModelIndex(), a_data.columnCount, chunk.columnCount - 1);
+		a_data.columnCount = chunk.columnCount;
+		endInsertColumns();
+	}
+	beginInsertRows(QModelIndex(), a_data.rowCount(), a_data.rowCount() + chunk.rowCount() - 1);
+	a_data.append(chunk);
+	endInsertRows();
+}
+
+/*!
+ * \brief Verwirft die bisher eingelesenen Zeilen
+ * \param ticket Nummer des Leseauftrags
+ *
+ * Wird aufgerufen, wenn der CsvParser die Datei mit einer anderen Kodierung von vorne liest.
+ */
+void ImportModel::clearRows(int ticket) {
+	if (ticket != a_ticket)
+		return;
+	beginResetModel();
 	a_data.clear();
+	endResetModel();
+}
 
-	str = stream.readAll().split(rowSeparator);
-	if (str.last() == QString())
-		str.removeLast();
-	for (int i = 0; i < str.count(); ++i) {
-		a_data.append(str[i].split(colSeparator));
-		if (a_data[i].count() > a_columnCount)
-			a_columnCount = a_data.last().count();
+/*!
+ * \brief Wird aufgerufen, wenn ein Leseauftrag beendet ist
+ * \param ticket Nummer des Leseauftrags
+ * \param error Fehlermeldung oder ""
+ */
+void ImportModel::parseFinished(int ticket, QString error) {
+	if (ticket != a_ticket)
+		return;
+	a_ticket = 0;
+	if (!error.isEmpty()) {
+		a_key.clear();
+		emit failed(error);
+		return;
 	}
-	emit dataChanged(createIndex(0, 0), createIndex(str.size(), a_columnCount));
-	f->close();
+	a_data.squeeze();
+	int cost = a_data.text.size() * sizeof(QChar)
+			+ (a_data.fieldEnds.size() + a_data.rowEnds.size()) * sizeof(int);
+	a_cache.insert(a_key, new CsvTable(a_data), cost);
+	emit loaded();
+}
+
+/*!
+ * \brief Erzeugt den Schlüssel für den Zwischenspeicher
+ * \param fileName Dateiname
+ * \param rowSeparator Zeilentrenner
+ * \param colSeparator Feldtrenner
+ * \return Schlüssel aus Pfad, Änderungszeit, Größe und Trennzeichen
+ */
+QString ImportModel::m_key(QString fileName, QChar rowSeparator, QChar colSeparator) {
+	QFileInfo info(fileName);
+	return QString("%1|%2|%3|%4%5").arg(info.absoluteFilePath()).arg(info.lastModified().toMSecsSinceEpoch())
+			.arg(info.size()).arg(rowSeparator).arg(colSeparator);
 }
 
 /*!
@@ -53,13 +144,11 @@ void ImportModel::setFileName(QString fileName, QChar rowSeparator, QChar colSep
  * \param role Art der Daten die abgefragt wird
  * \return Daten
  *
- * Mit Qt::DisplayRole als role wird der Inhalt von a_data an der Stelle ausgegeben, ansonsten QVariant().
+ * Mit Qt::DisplayRole als role wird der Inhalt des Feldes ausgegeben, ansonsten QVariant().
  */
 QVariant ImportModel::data(const QModelIndex &index, int role) const {
-	if (role == Qt::DisplayRole) {
-		if (a_data.size() > index.row() && a_data[index.row()].size() > index.column())
-			return a_data.at(index.row()).at(index.column());
-	}
+	if (role == Qt::DisplayRole && index.row() < a_data.rowCount() && index.column() < a_data.fieldCount(index.row()))
+		return a_data.field(index.row(), index.column());
 	return QVariant();
 }
 
@@ -74,7 +163,7 @@ QVariant ImportModel::data(const QModelIndex &index, int role) const {
  * Headers der entsprechende Inhalt von a_horizontalHeader ausgegeben.
  */
 QVariant ImportModel::headerData(int section, Qt::Orientation orientation, int role) const {
-	if (section >= a_columnCount || section >= a_horizontalHeader.size())
+	if (section >= a_data.columnCount || section >= a_horizontalHeader.size())
 		return QVariant();
 	if (role == Qt::DisplayRole) {
 		if (orientation == Qt::Horizontal)
@@ -91,7 +180,7 @@ QVariant ImportModel::headerData(int section, Qt::Orientation orientation, int r
  * \return Zeilenanzahl
  */
 int ImportModel::rowCount(const QModelIndex &/*parent*/ ) const {
-	return a_data.size();
+	return a_data.rowCount();
 }
 
 /*!
@@ -99,7 +188,7 @@ int ImportModel::rowCount(const QModelIndex &/*parent*/ ) const {
  * \return Spaltenzahl
  */
 int ImportModel::columnCount(const QModelIndex &/*parent*/ ) const {
-	return a_columnCount;
+	return a_data.columnCount;
 }
 
 /*!
@@ -116,7 +205,7 @@ void ImportModel::changeHeader(QStringList header) {
  * \param parent Eltern-Widget
  * \see m_createComponents(), m_alignComponents(), m_setInitialValues(), m_connectComponents()
  */
-ImportDialog::ImportDialog(QWidget *parent) : QDialog(parent)
+ImportDialog::ImportDialog(QWidget *parent) : QDialog(parent), a_trace("dialog", "ImportDialog")
 {
 	m_createComponents();
 	m_alignComponents();
@@ -138,8 +227,11 @@ void ImportDialog::m_createComponents() {
 	a_commonFormLetter = new QCheckBox(tr("Klassenbuchstabe"));
 	a_gradYear = new QLineEdit;
 	a_formLetter = new QLineEdit;
+	a_allOrNothing = new QCheckBox(tr("Nur vollständig importieren"));
+	a_engine = new QComboBox;
+	a_matchExisting = new QCheckBox(tr("Mit vorhandenen Schülern abgleichen"));
 	a_formattedInput = new QTableView;
-	a_inputDataModel = new ImportModel;
+	a_inputDataModel = new ImportModel(this);
 	a_rowSeparator = new QComboBox;
 	a_colSeparator = new QComboBox;
 }
@@ -168,6 +260,10 @@ void ImportDialog::m_alignComponents() {
 	c->addWidget(a_rowSeparator, 0, 3);
 	c->addWidget(new QLabel(tr("Feldtrenner")), 1, 2);
 	c->addWidget(a_colSeparator, 1, 3);
+	c->addWidget(a_allOrNothing, 2, 0, 1, 2);
+	c->addWidget(new QLabel(tr("Verfahren")), 2, 2);
+	c->addWidget(a_engine, 2, 3);
+	c->addWidget(a_matchExisting, 3, 0, 1, 2);
 	QGroupBox *commonGroup = new QGroupBox(tr("Allgemeine Daten"));
 	commonGroup->setLayout(c);
 
@@ -200,6 +296,9 @@ void ImportDialog::m_setInitialValues() {
 	a_colSeparator->addItem(tr("Tabulator"));
 
 	a_formattedInput->setModel(a_inputDataModel);
+	a_allOrNothing->setChecked(true);
+	a_engine->addItem(tr("Zeilenweise (INSERT)"));
+	a_engine->addItem(tr("Schnell (LOAD DATA)"));
 
 	a_gradYear->setValidator(new QRegExpValidator(QRegExp("[0-9]{4}")));
 	a_formLetter->setValidator(new QRegExpValidator(QRegExp("[a-gA-G]?")));
@@ -214,6 +313,9 @@ void ImportDialog::m_setInitialValues() {
 	a_formLetter->setToolTip(tr("Gemeinsamer Klassenbuchstabe"));
 	a_rowSeparator->setToolTip(tr("Welches Zeichen trennt die Zeilen?"));
 	a_colSeparator->setToolTip(tr("Welches Zeichen trennt die Spalten?"));
+	a_allOrNothing->setToolTip(tr("Nichts importieren, wenn auch nur eine Zeile fehlerhaft ist"));
+	a_matchExisting->setToolTip(tr("Vorhandene Schüler nicht erneut einfügen, sondern nur ihre Klasse ändern"));
+	a_engine->setToolTip(tr("LOAD DATA ist bei sehr großen Dateien schneller, muss aber vom Server erlaubt sein"));
 	a_formattedInput->setToolTip(tr("Vorschau der einzufügenden Daten"));
 }
 
@@ -225,9 +327,11 @@ void ImportDialog::m_connectComponents() {
 	connect(a_buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
 	connect(a_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 	for (int i = 0; i < a_numFields; ++i)
-		connect(a_field[i], SIGNAL(currentIndexChanged(int)), this, SLOT(refresh()));
+		connect(a_field[i], SIGNAL(currentIndexChanged(int)), this, SLOT(relabel()));
 	connect(a_colSeparator, SIGNAL(currentIndexChanged(int)), this, SLOT(refresh()));
 	connect(a_rowSeparator, SIGNAL(currentIndexChanged(int)), this, SLOT(refresh()));
+	connect(a_inputDataModel, SIGNAL(loaded()), a_formattedInput, SLOT(resizeColumnsToContents()));
+	connect(a_inputDataModel, SIGNAL(failed(QString)), this, SLOT(loadFailed(QString)));
 }
 
 /*!
@@ -255,72 +359,469 @@ void ImportDialog::openClicked()
 	refresh();
 }
 
+/*!
+ * \brief Liest den Inhalt einer Zelle aus a_inputDataModel
+ * \param row Zeile
+ * \param column Spalte oder -1
+ * \return Vereinfachter Inhalt der Zelle oder "", falls column -1 ist
+ */
+QString ImportDialog::m_cell(int row, int column) {
+	if (column == -1)
+		return QString();
+	return a_inputDataModel->data(a_inputDataModel->index(row, column), Qt::DisplayRole).toString().simplified();
+}
+
+/*!
+ * \brief Stellt die einzufügenden Schüler zusammen und prüft sie
+ * \param rows Nimmt die gültigen Zeilen auf
+ * \param errors Nimmt die Fehlermeldungen zu ungültigen Zeilen auf
+ * \return false - Die Feldzuordnung reicht für einen Import nicht aus
+ *
+ * Der Name wird entweder aus dem Namensfeld oder aus Nach- und Vorname zusammengesetzt. Abschlussjahr und
+ * Klassenbuchstabe werden aus der jeweiligen Spalte oder, falls diese leer ist, aus den allgemeinen Daten
+ * übernommen. Geprüft wird, ob die Werte in die Spalten von `schueler` passen.
+ */
+bool ImportDialog::m_collectRows(QList<ImportRow> *rows, QStringList *errors) {
+	int indName = m_getIndex(tr("Name"));
+	int indFName = m_getIndex(tr("Vorname"));
+	int indLName = m_getIndex(tr("Nachname"));
+	int indGrYear = m_getIndex(tr("Abschlussjahr"));
+	int indFoLetter = m_getIndex(tr("Klassenbuchstabe"));
+
+	if (indName == -1 && (indFName == -1 || indLName == -1)) {
+		QMessageBox::critical(this, tr("Fehlende Informationen"), tr("Um Schüler zu importieren, "
+			"muss es entweder ein Namensfeld oder eins mit Vor- und eins mit Nachnamen geben!"));
+		return false;
+	}
+
+	int count = a_inputDataModel->rowCount(QModelIndex());
+	rows->reserve(count);
+	for (int i = 0; i < count; ++i) {
+		ImportRow r;
+		r.line = i;
+		r.id = -1;
+		if (indName != -1)
+			r.name = m_cell(i, indName);
+		else
+			r.name = tr("%1 %2").arg(m_cell(i, indLName)).arg(m_cell(i, indFName)).simplified();
+		r.vajahr = m_cell(i, indGrYear);
+		if (r.vajahr.isEmpty() && a_commonGradYear->isChecked())
+			r.vajahr = a_gradYear->text();
+		r.kbuchst = m_cell(i, indFoLetter);
+		if (r.kbuchst.isEmpty() && a_commonFormLetter->isChecked())
+			r.kbuchst = a_formLetter->text();
+
+		if (r.name.isEmpty())
+			*errors << tr("Zeile %1: Kein Name").arg(i);
+		else if (r.name.size() > 50)
+			*errors << tr("Zeile %1: Name länger als 50 Zeichen").arg(i);
+		else if (!r.vajahr.isEmpty() && !QRegExp("[0-9]{4}").exactMatch(r.vajahr))
+			*errors << tr("Zeile %1: Ungültiges Abschlussjahr \"%2\"").arg(i).arg(r.vajahr);
+		else if (r.kbuchst.size() > 3)
+			*errors << tr("Zeile %1: Ungültiger Klassenbuchstabe \"%2\"").arg(i).arg(r.kbuchst);
+		else
+			rows->append(r);
+	}
+	return true;
+}
+
+/*!
+ * \brief Fügt Schüler mit einem einzigen mehrzeiligen INSERT ein
+ * \param rows Einzufügende Zeilen
+ * \return true - Kein Fehler; sonst steht der Fehler in a_q
+ *
+ * Ein leeres Abschlussjahr bzw. ein leerer Klassenbuchstabe wird als NULL eingefügt.
+ */
+bool ImportDialog::m_insertChunk(const QList<ImportRow> &rows) {
+	QString values;
+	for (int n = 0; n < rows.size(); ++n)
+		values += QString("%1(:name%2, :vajahr%2, :kbuchst%2)").arg(n == 0 ? "" : ", ").arg(n);
+	if (!a_q.prepare(tr("INSERT INTO `schueler` (`name`, `vajahr`, `kbuchst`) VALUES %1").arg(values)))
+		return false;
+	for (int n = 0; n < rows.size(); ++n) {
+		a_q.bindValue(QString(":name%1").arg(n), rows[n].name);
+		a_q.bindValue(QString(":vajahr%1").arg(n), rows[n].vajahr.isEmpty() ? QVariant(QVariant::Int)
+											 : QVariant(rows[n].vajahr.toInt()));
+		a_q.bindValue(QString(":kbuchst%1").arg(n), rows[n].kbuchst.isEmpty() ? QVariant(QVariant::String)
+											   : QVariant(rows[n].kbuchst));
+	}
+	return a_q.exec();
+}
+
+/*!
+ * \brief Normalisiert einen Namen für den Abgleich mit vorhandenen Schülern
+ * \param name Name
+ * \return Namensbestandteile in Kleinbuchstaben, alphabetisch sortiert
+ *
+ * Damit werden auch Namen gefunden, die sich nur in Groß-/Kleinschreibung, Leerzeichen oder der Reihenfolge
+ * von Vor- und Nachname unterscheiden.
+ */
+QString ImportDialog::m_nameKey(QString name) {
+	QStringList parts = name.toLower().split(' ', QString::SkipEmptyParts);
+	parts.sort();
+	return parts.join(' ');
+}
+
+/*!
+ * \brief Gleicht die Zeilen mit den vorhandenen Schülern ab
+ * \param rows Geprüfte Zeilen; enthält danach nur noch die neuen Schüler
+ * \param moved Nimmt die Zeilen auf, deren Schüler die Klasse gewechselt haben (mit ImportRow::id)
+ * \param unchanged Nimmt die Anzahl der unveränderten Schüler auf
+ * \param errors Nimmt die Fehlermeldungen zu mehrdeutigen Zeilen auf
+ * \return false - Die vorhandenen Schüler konnten nicht geladen werden
+ *
+ * Die vorhandenen Schüler werden einmal geladen und nach m_nameKey() in einen Hash eingeordnet, der Abgleich
+ * ist also linear in der Anzahl der Zeilen. Ein leeres Abschlussjahr bzw. ein leerer Klassenbuchstabe in der
+ * Datei passt zu jedem Wert. Gibt es zu einer Zeile keinen passenden, aber genau einen Schüler gleichen Namens
+ * und Abschlussjahrs, hat dieser die Klasse gewechselt; ebenso, wenn es keinen solchen, aber genau einen gleichen
+ * Namens gibt, dessen Abschlussjahr um höchstens eins abweicht (Wiederholen oder Überspringen einer Klasse).
+ * Liegen alle Schüler gleichen Namens weiter weg, ist es ein neuer Schüler. Jeder vorhandene Schüler wird
+ * höchstens einer Zeile zugeordnet.
+ */
+bool ImportDialog::m_classify(QList<ImportRow> *rows, QList<ImportRow> *moved, int *unchanged,
+			      QStringList *errors) {
+	QMultiHash<QString, ImportRow> existing;
+	QSet<int> used;
+	QList<ImportRow> added;
+
+	if (!a_q.exec("SELECT `id`, `name`, `vajahr`, `kbuchst` FROM `schueler`")) {
+		sqlError(a_q);
+		return false;
+	}
+	if (a_q.size() > 0)
+		existing.reserve(a_q.size());
+	while (a_q.next()) {
+		ImportRow e;
+		e.id = a_q.value(0).toInt();
+		e.name = a_q.value(1).toString();
+		e.vajahr = a_q.value(2).toString();
+		e.kbuchst = a_q.value(3).toString();
+		existing.insert(m_nameKey(e.name), e);
+	}
+
+	*unchanged = 0;
+	foreach (ImportRow r, *rows) {
+		QList<ImportRow> candidates;
+		foreach (const ImportRow &e, existing.values(m_nameKey(r.name)))
+			if (!used.contains(e.id))
+				candidates << e;
+		if (candidates.isEmpty()) {
+			added << r;
+			continue;
+		}
+
+		int match = -1, sameYear = -1, sameYearCount = 0, near = -1, nearCount = 0;
+		for (int i = 0; i < candidates.size() && match == -1; ++i) {
+			bool year = r.vajahr.isEmpty() || r.vajahr == candidates[i].vajahr;
+			bool letter = r.kbuchst.isEmpty() || r.kbuchst.compare(candidates[i].kbuchst, Qt::CaseInsensitive) == 0;
+			if (year && letter)
+				match = i;
+			else if (year) {
+				sameYear = i;
+				++sameYearCount;
+			} else if (candidates[i].vajahr.isEmpty() || qAbs(r.vajahr.toInt() - candidates[i].vajahr.toInt()) <= 1) {
+				near = i;
+				++nearCount;
+			}
+		}
+		if (match != -1) {
+			used.insert(candidates[match].id);
+			++*unchanged;
+			continue;
+		}
+		if (sameYearCount + nearCount == 0) {
+			added << r;
+			continue;
+		}
+
+		int target = sameYearCount == 1 ? sameYear : sameYearCount == 0 && nearCount == 1 ? near : -1;
+		if (target == -1) {
+			*errors << tr("Zeile %1: \"%2\" passt zu mehreren vorhandenen Schülern").arg(r.line).arg(r.name);
+			continue;
+		}
+		r.id = candidates[target].id;
+		used.insert(r.id);
+		moved->append(r);
+	}
+	*rows = added;
+	return true;
+}
+
+/*!
+ * \brief Ändert die Klasse von Schülern, die die Klasse gewechselt haben
+ * \param q Zu verwendendes Query-Objekt (bestimmt die Verbindung)
+ * \param rows Zeilen mit ImportRow::id
+ * \return true - Kein Fehler; sonst steht der Fehler in q
+ *
+ * Pro a_chunkRows Zeilen wird ein einziges UPDATE mit CASE ausgeführt. Leere Werte in der Datei lassen den
+ * vorhandenen Wert unverändert. Muss innerhalb einer Transaktion aufgerufen werden.
+ */
+bool ImportDialog::m_moveRows(TimedQuery &q, const QList<ImportRow> &rows) {
+	for (int start = 0; start < rows.size(); start += a_chunkRows) {
+		QList<ImportRow> chunk = rows.mid(start, a_chunkRows);
+		QString years, letters;
+		for (int n = 0; n < chunk.size(); ++n) {
+			years += QString(" WHEN :yid%1 THEN IFNULL(:vajahr%1, `vajahr`)").arg(n);
+			letters += QString(" WHEN :kid%1 THEN IFNULL(:kbuchst%1, `kbuchst`)").arg(n);
+		}
+		if (!q.prepare(tr("UPDATE `schueler` SET `vajahr` = CASE `id`%1 END, `kbuchst` = CASE `id`%2 END "
+				    "WHERE `id` IN (%3)").arg(years).arg(letters).arg(placeholders(":id", chunk.size()))))
+			return false;
+		for (int n = 0; n < chunk.size(); ++n) {
+			q.bindValue(QString(":yid%1").arg(n), chunk[n].id);
+			q.bindValue(QString(":kid%1").arg(n), chunk[n].id);
+			q.bindValue(QString(":id%1").arg(n), chunk[n].id);
+			q.bindValue(QString(":vajahr%1").arg(n), chunk[n].vajahr.isEmpty() ? QVariant(QVariant::Int)
+											      : QVariant(chunk[n].vajahr.toInt()));
+			q.bindValue(QString(":kbuchst%1").arg(n), chunk[n].kbuchst.isEmpty() ? QVariant(QVariant::String)
+												: QVariant(chunk[n].kbuchst));
+		}
+		if (!q.exec())
+			return false;
+	}
+	return true;
+}
+
+/*!
+ * \brief Fügt alle Schüler in einer Transaktion ein
+ * \param rows Einzufügende Zeilen
+ * \param moved Zeilen zu Schülern, die die Klasse gewechselt haben (siehe m_moveRows())
+ * \param errors Nimmt die Fehlermeldungen zu nicht eingefügten Zeilen auf
+ * \return Anzahl der eingefügten Schüler oder -1, falls nichts eingefügt wurde
+ *
+ * In derselben Transaktion werden zuerst die Klassenwechsel übernommen. Die Zeilen werden in Paketen zu a_chunkRows Zeilen eingefügt. Schlägt ein Paket fehl, wird bei
+ * "Nur vollständig importieren" alles zurückgerollt; sonst wird das Paket zeilenweise wiederholt, um die
+ * fehlerhaften Zeilen zu ermitteln. Ein fehlgeschlagenes Statement macht bei InnoDB nur sich selbst rückgängig,
+ * die Transaktion bleibt also gültig.
+ */
+int ImportDialog::m_insertRows(const QList<ImportRow> &rows, const QList<ImportRow> &moved, QStringList *errors) {
+	QSqlDatabase db = QSqlDatabase::database();
+	int inserted = 0;
+
+	if (!db.transaction()) {
+		sqlError(db.lastError(), "START TRANSACTION");
+		return -1;
+	}
+	if (!m_moveRows(a_q, moved)) {
+		sqlError(a_q);
+		db.rollback();
+		return -1;
+	}
+	for (int start = 0; start < rows.size(); start += a_chunkRows) {
+		QList<ImportRow> chunk = rows.mid(start, a_chunkRows);
+		if (m_insertChunk(chunk)) {
+			inserted += chunk.size();
+			continue;
+		}
+		if (a_allOrNothing->isChecked()) {
+			sqlError(a_q);
+			db.rollback();
+			return -1;
+		}
+		foreach (const ImportRow &r, chunk) {
+			if (m_insertChunk(QList<ImportRow>() << r))
+				++inserted;
+			else
+				*errors << tr("Zeile %1: %2").arg(r.line).arg(a_q.lastError().text());
+		}
+	}
+	if (!db.commit()) {
+		sqlError(db.lastError(), "COMMIT");
+		db.rollback();
+		return -1;
+	}
+	return inserted;
+}
+
+/*!
+ * \brief Importiert die Schüler über eine Hilfstabelle mit LOAD DATA LOCAL INFILE
+ * \param rows Geprüfte Zeilen
+ * \param moved Zeilen zu Schülern, die die Klasse gewechselt haben (siehe m_moveRows())
+ * \return Anzahl der eingefügten Schüler, -1 bei einem Fehler oder -2, falls der Server LOAD DATA LOCAL
+ *         nicht erlaubt
+ *
+ * LOAD DATA LOCAL erlaubt dem Server, beliebige lesbare Dateien des Clients anzufordern. Deshalb wird es nur
+ * für eine eigene, kurzlebige Verbindung mit MYSQL_OPT_LOCAL_INFILE=1 freigeschaltet, die nach dem Import
+ * wieder geschlossen wird; alle anderen Verbindungen bleiben ohne diese Option. Der Import selbst geschieht in
+ * m_loadStaging().
+ */
+int ImportDialog::m_loadRows(const QList<ImportRow> &rows, const QList<ImportRow> &moved) {
+	const QString connection = "obsidian_import";
+	int inserted;
+	{
+		QSqlDatabase db = QSqlDatabase::cloneDatabase(QSqlDatabase::database(), connection);
+		db.setConnectOptions("MYSQL_OPT_LOCAL_INFILE=1");
+		if (db.open()) {
+			inserted = m_loadStaging(db, rows, moved);
+		} else {
+			sqlError(db.lastError(), "CONNECT");
+			inserted = -1;
+		}
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connection);
+	return inserted;
+}
+
+/*!
+ * \brief Lädt die Schüler über die Verbindung aus m_loadRows() in die Datenbank
+ * \param db Verbindung mit MYSQL_OPT_LOCAL_INFILE=1
+ * \param rows Geprüfte Zeilen
+ * \param moved Zeilen zu Schülern, die die Klasse gewechselt haben (siehe m_moveRows())
+ * \return Wie m_loadRows()
+ *
+ * Name, Abschlussjahr und Klassenbuchstabe der gültigen Zeilen werden so, wie sie m_collectRows() geprüft und
+ * ergänzt hat, in eine temporäre Datei geschrieben und mit einem einzigen LOAD DATA in die temporäre Tabelle
+ * `import_staging` geladen. Ein einziges INSERT ... SELECT übernimmt sie dann unverändert in `schueler`; es werden
+ * also dieselben Werte eingefügt wie von m_insertRows(). Die Klassenwechsel und das INSERT ... SELECT laufen in
+ * einer gemeinsamen Transaktion auf derselben Verbindung.
+ */
+int ImportDialog::m_loadStaging(QSqlDatabase db, const QList<ImportRow> &rows, const QList<ImportRow> &moved) {
+	TimedQuery q(db);
+
+	if (!q.exec("SELECT @@local_infile") || !q.first() || !q.value(0).toBool())
+		return -2;
+
+	QTemporaryFile file(QDir::temp().filePath("obsidian-import-XXXXXX.txt"));
+	if (!file.open()) {
+		QMessageBox::critical(this, tr("Fehler"), tr("Temporäre Datei konnte nicht angelegt werden:\n%1")
+				      .arg(file.errorString()));
+		return -1;
+	}
+	QTextStream out(&file);
+	out.setCodec("UTF-8");
+	foreach (const ImportRow &r, rows)
+		out << escape(r.name) << '\t' << (r.vajahr.isEmpty() ? "\\N" : escape(r.vajahr)) << '\t'
+		    << (r.kbuchst.isEmpty() ? "\\N" : escape(r.kbuchst)) << '\n';
+	out.flush();
+	file.close();
+
+	if (!q.exec("DROP TEMPORARY TABLE IF EXISTS `import_staging`") ||
+	    !q.exec("CREATE TEMPORARY TABLE `import_staging` (`name` varchar(50) NOT NULL, "
+		    "`vajahr` int(11) DEFAULT NULL, `kbuchst` varchar(3) DEFAULT NULL)")) {
+		sqlError(q);
+		return -1;
+	}
+	if (!q.exec(tr("LOAD DATA LOCAL INFILE '%1' INTO TABLE `import_staging` CHARACTER SET utf8 "
+		       "FIELDS TERMINATED BY '\\t' LINES TERMINATED BY '\\n' "
+		       "(`name`, `vajahr`, `kbuchst`)").arg(escape(file.fileName())))) {
+		// 1148: ER_NOT_ALLOWED_COMMAND, 2068: CR_LOAD_DATA_LOCAL_INFILE_REJECTED, 3948: ER_CLIENT_LOCAL_FILES_DISABLED
+		QString code = q.lastError().nativeErrorCode();
+		if (code == "1148" || code == "2068" || code == "3948")
+			return -2;
+		sqlError(q);
+		return -1;
+	}
+
+	if (!db.transaction()) {
+		sqlError(db.lastError(), "START TRANSACTION");
+		return -1;
+	}
+	if (!m_moveRows(q, moved)) {
+		sqlError(q);
+		db.rollback();
+		return -1;
+	}
+	if (!q.exec("INSERT INTO `schueler` (`name`, `vajahr`, `kbuchst`) "
+		    "SELECT `name`, `vajahr`, `kbuchst` FROM `import_staging`")) {
+		sqlError(q);
+		db.rollback();
+		return -1;
+	}
+	int inserted = q.numRowsAffected();
+	if (!db.commit()) {
+		sqlError(db.lastError(), "COMMIT");
+		db.rollback();
+		return -1;
+	}
+	q.exec("DROP TEMPORARY TABLE IF EXISTS `import_staging`");
+	return inserted;
+}
+
+/*!
+ * \brief Zeigt eine Meldung mit den fehlerhaften Zeilen in den Details an
+ * \param icon Symbol der Meldung
+ * \param title Titel
+ * \param text Text der Meldung
+ * \param errors Fehlermeldungen zu den einzelnen Zeilen
+ * \param buttons Schaltflächen
+ * \return Gedrückte Schaltfläche
+ */
+int ImportDialog::m_report(QMessageBox::Icon icon, QString title, QString text, QStringList errors,
+			   QMessageBox::StandardButtons buttons) {
+	QMessageBox box(icon, title, text, buttons, this);
+	if (!errors.isEmpty())
+		box.setDetailedText(errors.join("\n"));
+	return box.exec();
+}
+
 /*!
  * \brief Wird beim Schließen des Dialogs aufgerufen
  *
- * Da alle Daten bereits richtig aufgeteilt in a_formattedInput vorliegen, wird einfach über die Zeilen
- * iteriert und schließlich eine passende SQL-Abfrage generiert, die den eingegebenen Daten gerecht wird.
+ * Zuerst werden alle Zeilen zusammengestellt und geprüft (siehe m_collectRows()) und, falls gewünscht, mit den
+ * vorhandenen Schülern abgeglichen (siehe m_classify()); dann werden nur neue Schüler eingefügt und nur
+ * Klassenwechsel geändert. Gibt es fehlerhafte Zeilen,
+ * wird bei "Nur vollständig importieren" abgebrochen, sonst nachgefragt, ob ohne sie importiert werden soll.
+ * Anschließend werden die Schüler je nach gewähltem Verfahren in einer Transaktion (siehe m_insertRows()) oder
+ * über LOAD DATA (siehe m_loadRows()) eingefügt und ggf. die Zeilen gemeldet, die nicht importiert wurden.
+ * Erlaubt der Server LOAD DATA LOCAL nicht, wird auf m_insertRows() ausgewichen.
  */
 void ImportDialog::accept()
 {
-	a_q.prepare("INSERT INTO `schueler` (`name`, `vajahr`, `kbuchst`) VALUES (:name,"
-		  ":vajahr, :kbuchst)");
-	QString name, grYear, foLetter;
-	int indName, indGrYear, indFoLetter, indFName, indLName;
-
-	indName = m_getIndex(tr("Name"));
-	indFName = m_getIndex(tr("Vorname"));
-	indLName = m_getIndex(tr("Nachname"));
-	indGrYear = m_getIndex(tr("Abschlussjahr"));
-	indFoLetter = m_getIndex(tr("Klassenbuchstabe"));
-
-	for (int i = 0; i < a_inputDataModel->rowCount(QModelIndex()); ++i) {
-		if (indName != -1)
-			name = a_inputDataModel->data(a_inputDataModel->index(i, indName),
-						      Qt::DisplayRole).toString().simplified();
-		else if (indFName != -1 && indLName != -1) {
-			QString fName = a_inputDataModel->data(a_inputDataModel->index(i, indFName),
-							       Qt::DisplayRole).toString().simplified();
-			QString lName = a_inputDataModel->data(a_inputDataModel->index(i, indLName),
-							       Qt::DisplayRole).toString().simplified();
-			name = tr("%1 %2").arg(lName).arg(fName);
-		} else {
-			QMessageBox::critical(this, tr("Fehlende Informationen"), tr("Um Schüler zu importieren,"
-				"muss es entweder ein Namensfeld oder eins mit Vor- und eins mit Nachnamen geben!"));
+	QList<ImportRow> rows, moved;
+	QStringList errors;
+	int unchanged = 0;
+
+	if (a_inputDataModel->isLoading()) {
+		QMessageBox::information(this, tr("Bitte warten"), tr("Die Datei wird noch eingelesen."));
+		return;
+	}
+	if (!m_collectRows(&rows, &errors))
+		return;
+	if (a_matchExisting->isChecked() && !m_classify(&rows, &moved, &unchanged, &errors))
+		return;
+	if (!errors.isEmpty()) {
+		if (a_allOrNothing->isChecked()) {
+			m_report(QMessageBox::Critical, tr("Fehlerhafte Zeilen"), tr("%1 Zeilen sind fehlerhaft, es wurde "
+				 "nichts importiert.").arg(errors.size()), errors, QMessageBox::Ok);
 			return;
 		}
-		if (a_commonGradYear->isChecked())
-			grYear = a_gradYear->text();
-		if (indGrYear != -1 && a_inputDataModel->data(a_inputDataModel->index(i, indGrYear),
-										Qt::DisplayRole).toString().simplified() != QString())
-			grYear = a_inputDataModel->data(a_inputDataModel->index(i, indGrYear),
-							Qt::DisplayRole).toString().simplified();
-		if (!a_commonGradYear->isChecked() && indGrYear == -1)
-			a_q.prepare("INSERT INTO `schueler` (`name`) VALUES (:name)");
-
-		if (a_commonFormLetter->isChecked())
-			foLetter = a_formLetter->text();
-		if (indFoLetter != -1 && a_inputDataModel->data(a_inputDataModel->index(i, indFoLetter),
-								Qt::DisplayRole).toString().simplified() != QString())
-			foLetter = a_inputDataModel->data(a_inputDataModel->index(i, indFoLetter),
-							  Qt::DisplayRole).toString();
-		a_q.bindValue(":name", name);
-		a_q.bindValue(":vajahr", grYear);
-		a_q.bindValue(":kbuchst", foLetter);
-		if (!::exec(a_q)) return;
+		if (m_report(QMessageBox::Question, tr("Fehlerhafte Zeilen"), tr("%1 Zeilen sind fehlerhaft und werden "
+			     "übersprungen. Trotzdem importieren?").arg(errors.size()), errors,
+			     QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
+			return;
 	}
+
+	int inserted = -2;
+	if (a_engine->currentIndex() == 1 && !rows.isEmpty()) {
+		inserted = m_loadRows(rows, moved);
+		if (inserted == -2)
+			QMessageBox::information(this, tr("Schneller Import nicht möglich"), tr("Der Server oder die "
+						 "Verbindung erlaubt LOAD DATA LOCAL nicht (local_infile). Die Schüler werden "
+						 "stattdessen mit mehrzeiligen INSERTs importiert."));
+	}
+	if (inserted == -2)
+		inserted = m_insertRows(rows, moved, &errors);
+	if (inserted == -1)
+		return;
+	if (!errors.isEmpty())
+		m_report(QMessageBox::Warning, tr("Import unvollständig"), tr("%1 Schüler wurden importiert, %2 Zeilen "
+			 "wurden übersprungen.").arg(inserted).arg(errors.size()), errors, QMessageBox::Ok);
+	else if (a_matchExisting->isChecked())
+		QMessageBox::information(this, tr("Import abgeschlossen"), tr("%1 Schüler neu, %2 mit geänderter Klasse, "
+					 "%3 unverändert.").arg(inserted).arg(moved.size()).arg(unchanged));
 	QDialog::accept();
 }
 
 /*!
  * \brief Wird aufgerufen um a_formattedInput zu aktualisieren
  *
- * Zuerst werden die Zeilen- und Feldtrenner in Zeichen umgewandelt und das Datenmodell dazu veranlasst,
- * seine Daten neu zu laden. Anschließend werden die Tabellenüberschriften neu gesetzt
+ * Wird nur bei Änderung der Datei oder der Trennzeichen aufgerufen. Zuerst werden die Zeilen- und Feldtrenner
+ * in Zeichen umgewandelt und das Datenmodell dazu veranlasst, seine Daten im Hintergrund neu zu laden.
+ * Anschließend werden die Tabellenüberschriften neu gesetzt (siehe relabel())
  */
 void ImportDialog::refresh() {
 	QChar rowSeparator, colSeparator;
-	QStringList headers;
 
 	switch (a_rowSeparator->currentIndex()) {
 	case 0:
@@ -343,9 +844,25 @@ void ImportDialog::refresh() {
 	}
 
 	a_inputDataModel->setFileName(a_fileName->text(), rowSeparator, colSeparator);
+	relabel();
+}
 
+/*!
+ * \brief Setzt die Tabellenüberschriften nach der Zuordnung der Felder
+ *
+ * Die Zuordnung der Spalten ändert nur die Überschriften, die Daten selbst bleiben unverändert.
+ */
+void ImportDialog::relabel() {
+	QStringList headers;
 	for (int i = 0; i < a_numFields; ++i)
 		headers.append(a_field[i]->currentText());
 	a_inputDataModel->changeHeader(headers);
-	a_formattedInput->resizeColumnsToContents();
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn die Datei nicht gelesen werden konnte
+ * \param error Fehlermeldung
+ */
+void ImportDialog::loadFailed(QString error) {
+	QMessageBox::warning(this, tr("Fehler beim Öffnen"), tr("Die Datei konnte nicht gelesen werden:\n%1").arg(error));
 }
@@ -8,22 +8,39 @@
 #include <QComboBox>
 #include <QCheckBox>
 #include <QFile>
-#include <QSqlQuery>
+#include "querystats.h"
+#include "tracer.h"
 #include <QAbstractTableModel>
 #include <QTableView>
+#include <QMessageBox>
+#include <QThread>
+#include <QCache>
+#include "csvparser.h"
 
 /*!
  * \brief Das Datenmodell für den ImportDialog
+ *
+ * Die Datei wird von einem CsvParser in einem eigenen Thread eingelesen; die Zeilen werden paketweise
+ * angehängt, sobald sie fertig sind. Vollständig eingelesene Dateien werden pro Datei und Trennzeichen
+ * zwischengespeichert, damit z.B. das Zurückschalten auf einen vorherigen Feldtrenner nicht erneut liest.
  */
 class ImportModel : public QAbstractTableModel {
 	Q_OBJECT
 private:
-	QList<QStringList> a_data;               ///< Enthält die Daten
+	CsvTable a_data;                         ///< Enthält die Daten
 	QStringList a_horizontalHeader;          ///< Enthält den Tabellenkopf
-	int a_columnCount;                       ///< Enthält die maximale Spaltenanzahl
+	QThread a_thread;                        ///< Thread, in dem a_parser lebt
+	CsvParser *a_parser;                     ///< Liest die Datei ein
+	int a_ticket;                            ///< Nummer des laufenden Leseauftrags (0: keiner)
+	int a_nextTicket;                        ///< Nummer des nächsten Leseauftrags
+	QString a_key;                           ///< Schlüssel der angezeigten bzw. gerade gelesenen Daten
+	QCache<QString, CsvTable> a_cache;       ///< Zuordnung Schlüssel->vollständig eingelesene Daten
+
+	static QString m_key(QString fileName, QChar rowSeparator, QChar colSeparator);
 
 public:
 	ImportModel(QObject *parent = 0);
+	~ImportModel();
 	QVariant data(const QModelIndex &index, int role) const;
 	QVariant headerData(int section, Qt::Orientation orientation, int role) const;
 	int rowCount(const QModelIndex &/*parent*/) const;
@@ -31,6 +48,28 @@ public:
 
 	void setFileName(QString fileName, QChar rowSeparator, QChar colSeparator);
 	void changeHeader(QStringList header);
+	bool isLoading() const {return a_ticket != 0;}
+
+private slots:
+	void appendRows(int ticket, CsvTable chunk);
+	void clearRows(int ticket);
+	void parseFinished(int ticket, QString error);
+
+signals:
+	void requested(int ticket, QString fileName, QChar rowSeparator, QChar colSeparator);
+	void loaded();
+	void failed(QString error);
+};
+
+/*!
+ * \brief Eine geprüfte, zum Einfügen bereite Zeile des ImportDialogs
+ */
+struct ImportRow {
+	int line;                                ///< Zeile in der Vorschau
+	QString name;                            ///< Name des Schülers
+	QString vajahr;                          ///< Abschlussjahr oder ""
+	QString kbuchst;                         ///< Klassenbuchstabe oder ""
+	int id;                                  ///< Id des vorhandenen Schülers oder -1
 };
 
 /*!
@@ -40,7 +79,9 @@ class ImportDialog : public QDialog {
 	Q_OBJECT
 private:
 	static constexpr int a_numFields = 6;    ///< Anzahl der Felder
-	QSqlQuery a_q;                           ///< Zu verwendendes QSqlQuery-Objekt
+	static constexpr int a_chunkRows = 500;  ///< Anzahl der Zeilen pro INSERT
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
 	QDialogButtonBox *a_buttonBox;           ///< Ok/Abbrechen
 	QPushButton *a_open;                     ///< Dient dem Öffnen einer Datei
 	QLineEdit *a_fileName;                   ///< Eingabefeld für den Dateinamen
@@ -49,12 +90,26 @@ private:
 	QCheckBox *a_commonFormLetter;           ///< Sind die Schüler in einer Klasse?
 	QLineEdit *a_gradYear;                   ///< Enthält das gemeinsame Abschlussjahr
 	QLineEdit *a_formLetter;                 ///< Enthält den gemeinsamen Klassenbuchstaben
+	QCheckBox *a_allOrNothing;               ///< Soll bei fehlerhaften Zeilen gar nichts importiert werden?
+	QComboBox *a_engine;                     ///< Verfahren zum Einfügen (INSERT oder LOAD DATA)
+	QCheckBox *a_matchExisting;              ///< Sollen vorhandene Schüler erkannt werden?
 	QComboBox *a_rowSeparator;               ///< Enthält den Zeilentrenner
 	QComboBox *a_colSeparator;               ///< Enthält den Spaltentrenner
 	QTableView *a_formattedInput;            ///< Zeigt das Endergebnis an
 	ImportModel *a_inputDataModel;           ///< Datenmodell für a_formattedInput
 
 	int m_getIndex(QString par);
+	QString m_cell(int row, int column);
+	bool m_collectRows(QList<ImportRow> *rows, QStringList *errors);
+	bool m_insertChunk(const QList<ImportRow> &rows);
+	static QString m_nameKey(QString name);
+	bool m_classify(QList<ImportRow> *rows, QList<ImportRow> *moved, int *unchanged, QStringList *errors);
+	bool m_moveRows(TimedQuery &q, const QList<ImportRow> &rows);
+	int m_insertRows(const QList<ImportRow> &rows, const QList<ImportRow> &moved, QStringList *errors);
+	int m_loadRows(const QList<ImportRow> &rows, const QList<ImportRow> &moved);
+	int m_loadStaging(QSqlDatabase db, const QList<ImportRow> &rows, const QList<ImportRow> &moved);
+	int m_report(QMessageBox::Icon icon, QString title, QString text, QStringList errors,
+		     QMessageBox::StandardButtons buttons);
 	void m_createComponents();
 	void m_alignComponents();
 	void m_setInitialValues();
@@ -65,6 +120,8 @@ public:
 private slots:
 	void openClicked();
 	void refresh();
+	void relabel();
+	void loadFailed(QString error);
 
 public slots:
 	void accept();
@@ -1,6 +1,7 @@
 #include "main.h"
 #include "insertdlg.h"
 #include "selectdlg.h"
+#include "bookindex.h"
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QGridLayout>
@@ -17,7 +18,7 @@
  * \see BaseDialog(), m_createInterface()
  */
 InsertDialog::InsertDialog(bool endOfTerm, QWidget *parent, QSqlRecord record)
-	: BaseDialog(endOfTerm, parent) {
+	: BaseDialog(endOfTerm, parent), a_trace("dialog", "InsertDialog") {
 	m_createInterface(record);
 }
 
@@ -82,11 +83,8 @@ void InsertDialog::m_setInitialValues(QSqlRecord record) {
  * \brief Wird bei Klick auf Ok aufgerufen
  *
  * Erst wird überprüft, ob überhaupt Bücher eingescannt wurden oder ob überhaupt ein Ausleihender ausgewählt wurde.
- * Bei normalen Ausleihen wird dann zunächst per SQL-Abfrage überprüft, ob das Buch von dem Schüler schon einmal
- * ausgeliehen wurde. In dem Falle wird einfach der Wert des `anzahl`-Feldes erhöht. Sonst wird ein neuer Datensatz
- * mit Schülernummer, den einzelnen ISBNs und Datum in die entsprechende Tabelle (`sausleihe`/`lausleihe`) eingefügt.
- *
- * Am Schuljahresende hingegen wird einfach nur ein Datensatz mit den entsprechenden Daten in `sausleihe` eingefügt.
+ * Anschließend werden alle Bücher in einer einzigen Transaktion verbucht (siehe m_insertXAusleihe() und
+ * m_insertBTausch()). Schlägt das fehl, bleibt der Dialog offen und es wurde nichts verändert.
  */
 void InsertDialog::accept() {
 	if (a_id == -1) {
@@ -98,61 +96,120 @@ void InsertDialog::accept() {
 		QMessageBox::warning(this, tr("Fehlende Angaben"), tr("Keine Bücher ausgewählt!"));
 		return;
 	}
-	if (!a_eot)
-		m_insertXAusleihe();
-	else
-		m_insertBTausch();
+	if (m_lookupsPending())
+		return;
+	if (!(a_eot ? m_insertBTausch() : m_insertXAusleihe()))
+		return;
 	QDialog::accept();
 }
 
 /*!
  * \brief Fügt die ISBNs in die btausch-Tabelle ein
+ * \return true - Alles wurde verbucht
+ *
+ * Innerhalb einer Transaktion wird mit einer Abfrage ermittelt, welche der Bücher der Schüler bereits hat.
+ * Diese und doppelt eingescannte Bücher werden gemeldet und übersprungen, alle anderen mit einem einzigen
+ * mehrzeiligen INSERT eingefügt.
  */
-void InsertDialog::m_insertBTausch() {
-	a_q.prepare("INSERT INTO `btausch` VALUES (:sid, :bid, :datum)");
-	for (int i = 0; i < a_numIsbns; ++i) {
-		if (a_alias[i]->text().isEmpty())
-			continue;
-		a_q.bindValue(":sid", a_id);
-		a_q.bindValue(":bid", a_isbn[i]);
-		a_q.bindValue(":datum", a_date->date().toString("yyyyMMdd"));
-		if (a_q.exec())
+bool InsertDialog::m_insertBTausch() {
+	QSqlDatabase db = QSqlDatabase::database();
+	QList<int> fields = m_scannedFields();
+	QSet<QString> present;
+	QStringList duplicates;
+	QList<int> inserted;
+	QString values;
+
+	if (!db.transaction()) {
+		sqlError(db.lastError(), "START TRANSACTION");
+		return false;
+	}
+	a_q.prepare(tr("SELECT `bid` FROM `btausch` WHERE `sid` = :sid AND `bid` IN (%1) FOR UPDATE")
+		    .arg(placeholders(":bid", fields.size())));
+	a_q.bindValue(":sid", a_id);
+	for (int n = 0; n < fields.size(); ++n)
+		a_q.bindValue(QString(":bid%1").arg(n), a_isbn[fields[n]]);
+	if (!::exec(a_q)) {
+		db.rollback();
+		return false;
+	}
+	while (a_q.next())
+		present.insert(a_q.value(0).toString());
+
+	foreach (int i, fields) {
+		if (present.contains(a_isbn[i])) {
+			duplicates << a_title[i]->text();
 			continue;
-		else
-			QMessageBox::warning(this, tr("Buch doppelt"),
-					     tr("Das Buch %1 wurde doppelt eingescannt").arg(a_title[i]->text()));
+		}
+		present.insert(a_isbn[i]);
+		inserted << i;
+	}
+	if (!inserted.isEmpty()) {
+		for (int n = 0; n < inserted.size(); ++n)
+			values += QString("%1(:sid%2, :bid%2, :datum%2)").arg(n == 0 ? "" : ", ").arg(n);
+		a_q.prepare(tr("INSERT INTO `btausch` VALUES %1").arg(values));
+		for (int n = 0; n < inserted.size(); ++n) {
+			a_q.bindValue(QString(":sid%1").arg(n), a_id);
+			a_q.bindValue(QString(":bid%1").arg(n), a_isbn[inserted[n]]);
+			a_q.bindValue(QString(":datum%1").arg(n), a_date->date().toString("yyyyMMdd"));
+		}
+		if (!::exec(a_q)) {
+			db.rollback();
+			return false;
+		}
+	}
+	if (!db.commit()) {
+		sqlError(db.lastError(), "COMMIT");
+		db.rollback();
+		return false;
 	}
+
+	foreach (int i, inserted)
+		a_changed.append(qMakePair(a_id, a_isbn[i]));
+	if (!duplicates.isEmpty())
+		QMessageBox::warning(this, tr("Buch doppelt"), tr("Folgende Bücher wurden doppelt eingescannt:\n%1")
+				     .arg(duplicates.join("\n")));
+	return true;
 }
 
 /*!
  * \brief Fügt die Bücher in lausleihe oder sausleihe ein
+ * \return true - Alles wurde verbucht
+ *
+ * Alle Bücher werden in einer Transaktion mit einem einzigen mehrzeiligen INSERT ... ON DUPLICATE KEY UPDATE
+ * eingefügt: Hatte der Ausleihende das Buch schon, wird `anz` erhöht und das Datum aktualisiert. Das gilt auch
+ * für Bücher, die im Dialog mehrfach eingescannt wurden.
  */
-void InsertDialog::m_insertXAusleihe() {
-	QSqlQuery ins, sel, upd;
-	sel.prepare(tr("SELECT * FROM `%1ausleihe` WHERE `%1id` = :lid AND `bid` = :bid")
-		    .arg(a_student->isChecked() ? "s" : "l"));
-	upd.prepare(tr("UPDATE `%1ausleihe` SET `anz` = `anz` + 1, `adatum` = :datum WHERE `%1id` = :lid AND `bid` = :bid")
-		    .arg(a_student->isChecked() ? "s" : "l"));
-	ins.prepare(tr("INSERT INTO `%1ausleihe` VALUES (:lid, :bid, :anz, :datum)").arg(a_student->isChecked() ? "s" : "l"));
-	for (int i = 0; i < a_numIsbns; ++i) {
-		if (a_alias[i]->text().isEmpty())
-			continue;
-		sel.bindValue(":lid", a_id);
-		sel.bindValue(":bid", a_isbn[i]);
-		if (!::exec(sel)) return;
-		if (sel.size() > 0) {
-			upd.bindValue(":lid", a_id);
-			upd.bindValue(":bid", a_isbn[i]);
-			upd.bindValue(":datum", a_date->date().toString("yyyyMMdd"));
-			if (!::exec(upd)) return;
-		} else {
-			ins.bindValue(":lid", a_id);
-			ins.bindValue(":bid", a_isbn[i]);
-			ins.bindValue(":anz", 1);
-			ins.bindValue(":datum", a_date->date().toString("yyyyMMdd"));
-			if (!::exec(ins)) return;
-		}
+bool InsertDialog::m_insertXAusleihe() {
+	QSqlDatabase db = QSqlDatabase::database();
+	QList<int> fields = m_scannedFields();
+	QString values;
+
+	for (int n = 0; n < fields.size(); ++n)
+		values += QString("%1(:lid%2, :bid%2, 1, :datum%2)").arg(n == 0 ? "" : ", ").arg(n);
+	a_q.prepare(tr("INSERT INTO `%1ausleihe` VALUES %2 ON DUPLICATE KEY UPDATE `anz` = `anz` + 1, "
+		       "`adatum` = VALUES(`adatum`)").arg(a_student->isChecked() ? "s" : "l").arg(values));
+	for (int n = 0; n < fields.size(); ++n) {
+		a_q.bindValue(QString(":lid%1").arg(n), a_id);
+		a_q.bindValue(QString(":bid%1").arg(n), a_isbn[fields[n]]);
+		a_q.bindValue(QString(":datum%1").arg(n), a_date->date().toString("yyyyMMdd"));
+	}
+
+	if (!db.transaction()) {
+		sqlError(db.lastError(), "START TRANSACTION");
+		return false;
 	}
+	if (!::exec(a_q)) {
+		db.rollback();
+		return false;
+	}
+	if (!db.commit()) {
+		sqlError(db.lastError(), "COMMIT");
+		db.rollback();
+		return false;
+	}
+	foreach (int i, fields)
+		a_changed.append(qMakePair(a_id, a_isbn[i]));
+	return true;
 }
 
 /*!
@@ -163,7 +220,8 @@ void InsertDialog::m_insertXAusleihe() {
  *
  * Alle Aufgaben werden weiterdelegiert.
  */
-InsertionDialog::InsertionDialog(int tabIndex, QWidget *parent) : QDialog(parent) {
+InsertionDialog::InsertionDialog(int tabIndex, QWidget *parent) : QDialog(parent),
+	a_trace("dialog", "InsertionDialog") {
 	m_createComponents();
 	m_alignComponents();
 	tabChanged(tabIndex);
@@ -295,14 +353,20 @@ void InsertionDialog::tabChanged(int tabIndex) {
  * \brief Wird bei Klick auf Ok aufgerufen.
  *
  * Je nach Index werden in die verschiedenen Tabellen Daten eingefügt (SQL-Abfragen).
+ * Neue Bücher und Aliasse werden zusätzlich in den BookIndex eingetragen. Die ISBN wird dafür wie bei der Suche
+ * mit BookIndex::normalizeIsbn() vereinheitlicht, damit lookup() das Buch unter demselben Schlüssel findet.
  */
 void InsertionDialog::accept() {
+	QString isbn;
+
 	switch (a_tabIndex) {
 	case 0:
+		isbn = BookIndex::normalizeIsbn(a_aliasIsbn->text());
 		a_q.prepare("INSERT INTO `aliasse` VALUES (:alias, :isbn)");
 		a_q.bindValue(":alias", a_aliasName->text().toLower());
-		a_q.bindValue(":isbn", a_aliasIsbn->text());
+		a_q.bindValue(":isbn", isbn);
 		if (!::exec(a_q)) return;
+		BookIndex::instance()->insertAlias(a_aliasName->text(), isbn);
 		break;
 	case 1:
 		a_q.prepare("INSERT INTO `schueler` VALUES (NULL, :name, :vajahr, :kbuchst)");
@@ -320,11 +384,13 @@ void InsertionDialog::accept() {
 		break;
 
 	case 3:
+		isbn = BookIndex::normalizeIsbn(a_bookIsbn->text());
 		a_q.prepare("INSERT INTO `buch` VALUES (:isbn, :titel, :jgst)");
-		a_q.bindValue(":isbn", a_bookIsbn->text());
+		a_q.bindValue(":isbn", isbn);
 		a_q.bindValue(":titel", a_bookTitle->text());
 		a_q.bindValue(":jgst", a_bookForm->text());
 		if (!::exec(a_q)) return;
+		BookIndex::instance()->insertBook(isbn, a_bookTitle->text(), a_bookForm->text());
 		break;
 	}
 	QDialog::accept();
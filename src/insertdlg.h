@@ -15,12 +15,13 @@ public:
 	InsertDialog(bool endOfTerm, QWidget *parent = 0, QSqlRecord record = QSqlRecord());
 
 private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
 	QDateEdit *a_date;                       ///< Enthält das Ausleihdatum
 	void m_createComponents();
 	void m_alignComponents();
 	void m_setInitialValues(QSqlRecord record);
-	void m_insertBTausch();
-	void m_insertXAusleihe();
+	bool m_insertBTausch();
+	bool m_insertXAusleihe();
 
 public slots:
 	void accept();
@@ -32,8 +33,9 @@ public slots:
 class InsertionDialog : public QDialog {
 	Q_OBJECT
 private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
 	int a_tabIndex;                          ///< Tab in den Eingefügt werden soll
-	QSqlQuery a_q;                           ///< Zu verwendendes QSqlQuery-Objekt
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
 	QDialogButtonBox *a_buttonBox;           ///< Ok/Abbrechen
 	QTabWidget *a_tabWidget;                 ///< Strukturiert die Eingabefelder
 	QLineEdit *a_studentName;                ///< Enthält den Namen eines Schülers
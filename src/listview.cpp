@@ -1,5 +1,6 @@
 #include "listview.h"
 #include "main.h"
+#include "executor.h"
 #include "insertdlg.h"
 #include "deletedlg.h"
 #include <QtGui>
@@ -38,47 +39,70 @@ void ListStyle::drawControl(ControlElement element, const QStyleOption *option,
  * \brief Konstruktor von ListModel
  * \param parent Elternobjekt
  *
- * Es werden ledeglich alle Listen geleert.
+ * Die Listen sind zu Beginn leer. Das Modell wird mit dem QueryExecutor verbunden, der
+ * die Daten im Hintergrund lädt.
  */
-ListModel::ListModel(QObject *parent) : QAbstractTableModel(parent) {
-	a_students.clear();
-	a_books.clear();
-	a_lent.clear();
+ListModel::ListModel(QObject *parent) : QAbstractTableModel(parent), a_displayedForm(0),
+	a_headerTicket(0), a_dataTicket(0) {
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(loadResult(QueryResult)));
 }
 
 /*!
  * \brief Lädt die Headers (also Schüler- und Bücherliste)
  *
- * Erst werden alle Lehrbücher für die entsprechende Jahrgangsstufe abgefragt und in
- * a_books gespeichert. Anschließend werden alle Schüler abgefragt, die in der
- * Klasse sind und in a_students eingetragen. Schließlich wird headerChanged() emittiert.
+ * Die Abfragen nach den Lehrbüchern der Jahrgangsstufe und nach den Schülern der Klasse werden
+ * an den QueryExecutor übergeben. Ein noch ausstehender Ladevorgang wird dabei verworfen.
+ * Das Ergebnis wird in m_applyHeader() übernommen.
  */
 void ListModel::loadHeader() {
+	TraceScope trace("model", "ListModel::loadHeader");
 	Q_ASSERT(!a_form.isEmpty());
 	Q_ASSERT(a_displayedForm != 0);
 
-	a_books.clear();
-	a_q.prepare("SELECT * FROM `Buch` WHERE `titel` LIKE :jgst ORDER BY `titel`");
-	a_q.bindValue(":jgst", tr("%%%1%%").arg(a_displayedForm));
-	if (!::exec(a_q))
-		return;
-	while (a_q.next())
-		a_books[a_q.value("titel").toString()] = a_q.value("isbn").toString();
-
-	a_students.clear();
-	a_showed.clear();
-	a_q.prepare("SELECT * FROM `SSchueler` WHERE `Klasse` = :klasse ORDER BY `Name`");
-	a_q.bindValue(":klasse", a_form);
-	if (!::exec(a_q))
-		return;
-	while (a_q.next()) {
-		a_students[a_q.value("Name").toString()] = a_q.value("id").toInt();
-		a_showed.append(a_q.value("id").toInt());
-	}
+	QVariantMap jgst;
+	jgst[":jgst"] = tr("%%%1%%").arg(a_displayedForm);
+	a_headerTicket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "header"), QList<QueryRequest>()
+		<< QueryRequest("SELECT `isbn`, `titel` FROM `Buch` WHERE `titel` LIKE :jgst ORDER BY `titel`", jgst)
+		<< QueryRequest(QString("SELECT `id`, `name` FROM `schueler` WHERE %1 ORDER BY `name`")
+				.arg(formFilter(a_form))));
+}
 
+/*!
+ * \brief Übernimmt die geladenen Headers
+ * \param result Ergebnis von loadHeader()
+ *
+ * Die Lehrbücher werden spaltenweise in a_bookIsbns/a_bookTitles gespeichert, die Schüler
+ * zeilenweise in a_studentIds/a_studentNames. Die Rückwärtszuordnungen a_bookColumns und
+ * a_studentRows werden dabei mit aufgebaut und die Bitmatrix neu dimensioniert.
+ */
+void ListModel::m_applyHeader(const QueryResult &result) {
+	TraceScope trace("model", "ListModel::applyHeader");
+	beginResetModel();
+	a_bookIsbns.clear();
+	a_bookTitles.clear();
+	a_bookColumns.clear();
+	a_studentIds.clear();
+	a_studentNames.clear();
+	a_studentRows.clear();
+	a_lent.clear();
+	a_free.clear();
 
-	emit headerDataChanged(Qt::Horizontal, 0, a_books.count());
-	emit headerDataChanged(Qt::Vertical, 0, a_students.count());
+	foreach (const QVariantList &row, result.sets.value(0).rows) {
+		QString isbn = row[0].toString();
+		a_bookColumns.insert(isbn, a_bookIsbns.size());
+		a_bookIsbns.append(isbn);
+		a_bookTitles.append(row[1].toString());
+	}
+	foreach (const QVariantList &row, result.sets.value(1).rows) {
+		int sid = row[0].toInt();
+		a_studentRows.insert(sid, a_studentIds.size());
+		a_studentIds.append(sid);
+		a_studentNames.append(row[1].toString());
+	}
+
+	a_lent.resize(a_studentIds.size() * a_bookIsbns.size());
+	a_free.resize(a_studentIds.size());
+	endResetModel();
 }
 
 /*!
@@ -87,14 +111,12 @@ void ListModel::loadHeader() {
  * \param role Gibt an, was abgefragt wird
  * \return Qt::Checked - Ausgegeben, Qt::Unchecked - Nicht ausgegeben
  *
- * Mithilfe von m_isSet wird überprüft, ob das Buch dem Schüler gegeben wurde.
+ * Mithilfe von m_isLent() wird in der Bitmatrix nachgesehen, ob das Buch dem Schüler gegeben wurde.
  */
 QVariant ListModel::data(const QModelIndex &index, int role) const {
 	if (role == Qt::CheckStateRole)
-		return (a_lent.value(a_showed[index.row()]).value(
-				a_books.values().at(index.column()))) ?
-				Qt::Checked : Qt::Unchecked;
-	else if (role == Qt::BackgroundRole && a_free[a_showed[index.row()]])
+		return m_isLent(index.row(), index.column()) ? Qt::Checked : Qt::Unchecked;
+	else if (role == Qt::BackgroundRole && a_free.testBit(index.row()))
 		return STUDENT_FREE;
 	else
 		return QVariant();
@@ -108,17 +130,17 @@ QVariant ListModel::data(const QModelIndex &index, int role) const {
  * \return Beschriftung der Zeile/Spalte
  *
  * Je nachdem, ob der horizontale oder der vertikale Header erfragt wird, wird entweder
- * a_books oder a_students zu Rate gezogen.
+ * a_bookTitles oder a_studentNames direkt über den Index zu Rate gezogen.
  */
 QVariant ListModel::headerData(int section, Qt::Orientation orientation, int role) const {
 	if (role == Qt::DisplayRole) {
 		if (orientation == Qt::Horizontal)
-			return a_books.keys().at(section);
+			return a_bookTitles.value(section);
 		else
-			return a_students.key(a_showed[section]);
+			return a_studentNames.value(section);
 	} else if (role == Qt::SizeHintRole && orientation == Qt::Horizontal)
-		return QSize(qApp->fontMetrics().height(), qMin(qApp->fontMetrics().width(a_books.keys().at(section)) + 10, 200));
-	else if (role == Qt::BackgroundRole && orientation == Qt::Horizontal && a_free[a_showed[section]])
+		return QSize(qApp->fontMetrics().height(), qMin(qApp->fontMetrics().width(a_bookTitles.value(section)) + 10, 200));
+	else if (role == Qt::BackgroundRole && orientation == Qt::Vertical && section < a_free.size() && a_free.testBit(section))
 		return STUDENT_FREE;
 	return QAbstractTableModel::headerData(section, orientation, role);
 }
@@ -128,7 +150,7 @@ QVariant ListModel::headerData(int section, Qt::Orientation orientation, int rol
  * \return Anzahl der Zeilen(Schüler)
  */
 int ListModel::rowCount(const QModelIndex &) const {
-	return a_students.count();
+	return a_studentIds.size();
 }
 
 /*!
@@ -136,37 +158,131 @@ int ListModel::rowCount(const QModelIndex &) const {
  * \return Anzahl der Spalten(Bücher)
  */
 int ListModel::columnCount(const QModelIndex &) const {
-	return a_books.count();
+	return a_bookIsbns.size();
 }
 
 /*!
  * \brief Lädt die Daten
  *
- * Für jeden Schüler wird aus `BTausch` eine SELECT-Abfrage gestartet, und danach zu jedem Buch
- * in a_lent das entsprechende Bit gesetzt (mithilfe vom m_set()). Anschließend wird dataChanged() emittiert.
+ * Statt für jeden Schüler einzeln `btausch` und `sausleihe` abzufragen, werden die Ausgaben der
+ * gesamten Klasse mit einer einzigen verknüpften Abfrage geholt. Eine zweite, gruppierte Abfrage
+ * liefert die Schüler, die noch Ausleihen in `sausleihe` haben. Beide laufen im QueryExecutor;
+ * das Ergebnis wird in m_applyData() übernommen.
  */
 void ListModel::loadData() {
-	QSqlQuery swap;
+	TraceScope trace("model", "ListModel::loadData");
+	QString klasse = formFilter(a_form, "`s`");
+	a_dataTicket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "data"), QList<QueryRequest>()
+		<< QueryRequest(QString("SELECT `sa`.`sid` FROM `sausleihe` `sa` JOIN `schueler` `s` ON `s`.`id` = `sa`.`sid` "
+					"WHERE %1 GROUP BY `sa`.`sid`").arg(klasse))
+		<< QueryRequest(QString("SELECT `bt`.`sid`, `bt`.`bid` FROM `btausch` `bt` JOIN `schueler` `s` "
+					"ON `s`.`id` = `bt`.`sid` WHERE %1").arg(klasse)));
+}
 
-	a_lent.clear();
-	swap.prepare("SELECT * FROM sausleihe WHERE sid = :sid");
-	a_q.prepare("SELECT * FROM `btausch` WHERE `sid` = :sid");
-	foreach (int sid, a_students.values()) {
-		a_q.bindValue(":sid", sid);
-		swap.bindValue(":sid", sid);
-		a_lent.insert(sid, {});
-		if (!::exec(a_q))
-			return;
-		if (!::exec(swap))
-			return;
-		a_free[sid] = (a_q.size() == 0) && (swap.size() == 0);
-		while (a_q.next()) {
-			if (a_books.values().contains(a_q.value("bid").toString()))
-				a_lent[sid].insert(a_q.value("bid").toString(), true);
-		}
+/*!
+ * \brief Übernimmt die geladenen Daten
+ * \param result Ergebnis von loadData()
+ *
+ * Beide Ergebnismengen werden in einem Durchlauf in die Bitmatrix a_lent und in a_free eingetragen.
+ * Anschließend werden dataChanged() und loaded() emittiert.
+ */
+void ListModel::m_applyData(const QueryResult &result) {
+	TraceScope trace("model", "ListModel::applyData");
+	int columns = a_bookIsbns.size();
+
+	a_lent.fill(false);
+	a_free.fill(true);
+
+	foreach (const QVariantList &row, result.sets.value(0).rows) {
+		int r = a_studentRows.value(row[0].toInt(), -1);
+		if (r != -1)
+			a_free.clearBit(r);
+	}
+	foreach (const QVariantList &row, result.sets.value(1).rows) {
+		int r = a_studentRows.value(row[0].toInt(), -1);
+		int column = a_bookColumns.value(row[1].toString(), -1);
+		if (r == -1)
+			continue;
+		a_free.clearBit(r);
+		if (column != -1)
+			a_lent.setBit(r * columns + column);
 	}
 
-	emit dataChanged(createIndex(0, 0), createIndex(a_students.count(), a_books.count()));
+	if (!a_studentIds.isEmpty() && columns > 0)
+		emit dataChanged(createIndex(0, 0), createIndex(a_studentIds.size() - 1, columns - 1));
+	if (!a_studentIds.isEmpty())
+		emit headerDataChanged(Qt::Vertical, 0, a_studentIds.size() - 1);
+	emit loaded();
+}
+
+/*!
+ * \brief Nimmt die Ergebnisse des QueryExecutors entgegen
+ * \param result Ergebnis eines beliebigen Auftrags
+ *
+ * Nur die Ergebnisse der eigenen, noch aktuellen Aufträge werden übernommen.
+ */
+void ListModel::loadResult(QueryResult result) {
+	if (result.ticket != a_headerTicket && result.ticket != a_dataTicket)
+		return;
+	if (!result.ok()) {
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+	if (result.ticket == a_headerTicket)
+		m_applyHeader(result);
+	else
+		m_applyData(result);
+}
+
+/*!
+ * \brief Trägt einzelne Änderungen in die Bitmatrix ein, ohne alles neu zu laden
+ * \param changes Geänderte Ausleihen als Paare (SId, ISBN)
+ * \param lent true - Bücher wurden ausgegeben, false - Bücher wurden zurückgegeben
+ *
+ * Für jedes Paar, dessen Schüler und Buch gerade angezeigt werden, wird das entsprechende Bit gesetzt
+ * bzw. gelöscht und dataChanged() nur für diese Zelle emittiert. Danach wird für die betroffenen Schüler
+ * geprüft, ob sie noch Bücher zurückzugeben haben, und ggf. deren Zeile samt Header aktualisiert.
+ */
+void ListModel::applyChanges(const QList<QPair<int, QString>> &changes, bool lent) {
+	QSet<int> rows;
+	typedef QPair<int, QString> Change;
+
+	foreach (const Change &change, changes) {
+		int row = a_studentRows.value(change.first, -1);
+		if (row == -1)
+			continue;
+		rows.insert(row);
+		int column = a_bookColumns.value(change.second, -1);
+		if (column == -1)
+			continue;
+		a_lent.setBit(row * a_bookIsbns.size() + column, lent);
+		emit dataChanged(index(row, column), index(row, column), QVector<int>() << Qt::CheckStateRole);
+	}
+	foreach (int row, rows) {
+		bool free = lent ? false : m_isFree(a_studentIds[row]);
+		if (free == a_free.testBit(row))
+			continue;
+		a_free.setBit(row, free);
+		if (!a_bookIsbns.isEmpty())
+			emit dataChanged(index(row, 0), index(row, a_bookIsbns.size() - 1),
+					 QVector<int>() << Qt::BackgroundRole);
+		emit headerDataChanged(Qt::Vertical, row, row);
+	}
+}
+
+/*!
+ * \brief Prüft, ob ein Schüler keine Bücher mehr zurückzugeben hat
+ * \param sid Id des Schülers
+ * \return true - Weder in `btausch` noch in `sausleihe` gibt es Einträge
+ */
+bool ListModel::m_isFree(int sid) {
+	a_q.prepare("SELECT EXISTS(SELECT 1 FROM `btausch` WHERE `sid` = :sid) OR "
+		    "EXISTS(SELECT 1 FROM `sausleihe` WHERE `sid` = :sid2)");
+	a_q.bindValue(":sid", sid);
+	a_q.bindValue(":sid2", sid);
+	if (!::exec_first(&a_q))
+		return false;
+	return !a_q.value(0).toBool();
 }
 
 /*!
@@ -179,6 +295,25 @@ void ListModel::setForm(QString form) {
 	a_form = form;
 }
 
+/*!
+ * \brief Gibt einen Schüler der angezeigten Klasse als Datensatz zurück
+ * \param row Zeile
+ * \return Datensatz mit den Feldern id, Klasse und Name wie im View `SSchueler`
+ */
+QSqlRecord ListModel::record(int row) const {
+	QSqlRecord r;
+	QSqlField id("id", QVariant::Int);
+	QSqlField form("Klasse", QVariant::String);
+	QSqlField name("Name", QVariant::String);
+	id.setValue(a_studentIds.value(row));
+	form.setValue(a_form);
+	name.setValue(a_studentNames.value(row));
+	r.append(id);
+	r.append(form);
+	r.append(name);
+	return r;
+}
+
 /*!
  * \brief Setzt die Jahrgangsstufe, deren Bücher anzuzeigen sind
  * \param form Neue Jahrgangsstufe
@@ -195,13 +330,14 @@ void ListModel::exportData() {
 	if (file.open(QFile::WriteOnly | QFile::Text)) {
 		QTextStream stream(&file);
 		a_q.prepare("SELECT * FROM btausch WHERE sid = :sid");
-		foreach (int sid, a_showed) {
-			a_q.bindValue(":sid", sid);
+		for (int row = 0; row < a_studentIds.size(); ++row) {
+			a_q.bindValue(":sid", a_studentIds[row]);
 			if (!::exec(a_q))
 				continue;
 			while (a_q.next()) {
-				stream << qSetFieldWidth(40) << qSetPadChar('.') << a_students.key(sid) <<
-					  qSetFieldWidth(0) << a_books.key(a_q.record().value("bid").toString()) << endl;
+				int column = a_bookColumns.value(a_q.record().value("bid").toString(), -1);
+				stream << qSetFieldWidth(40) << qSetPadChar('.') << a_studentNames[row] <<
+					  qSetFieldWidth(0) << (column == -1 ? QString() : a_bookTitles[column]) << endl;
 			}
 		}
 		file.close();
@@ -293,8 +429,8 @@ void ListView::m_setInitialValues() {
 	m_populateCombo();
 	changeForm(a_form->currentText());
 	toggle();
-	a_tableView->resizeColumnsToContents();
 	a_tableView->setModel(a_tableModel);
+	fitColumns();
 }
 
 /*!
@@ -303,22 +439,27 @@ void ListView::m_setInitialValues() {
 void ListView::m_connectComponents() {
 	connect(a_form, SIGNAL(currentTextChanged(QString)), this, SLOT(changeForm(QString)));
 	connect(a_oldList, SIGNAL(toggled(bool)), this, SLOT(toggle()));
+	connect(a_tableModel, SIGNAL(loaded()), this, SLOT(fitColumns()));
 }
 
 /*!
  * \brief Lädt die Klassen neu (ComboBox)
  *
- * Es wird der Index gespeichert, anschließend eine SELECT-Abfrage gestartet, um die Klassen zu
- * erfragend, alle Klassen hinzugefügt und schließlich der Index wieder gesetzt.
+ * Die Klassen werden aus den verschiedenen Abschlussjahren und Klassenbuchstaben berechnet (siehe
+ * formName()); die Abfrage kommt dabei mit dem Index auf (`vajahr`, `kbuchst`) aus. Sortiert wird nach
+ * Jahrgangsstufe.
  */
 void ListView::m_populateCombo() {
+	QStringList forms;
 	a_form->clear();
-	if (!a_q.exec("SELECT DISTINCT `Klasse` FROM `SSchueler` ORDER BY `Klasse`;")) return;
-	if (a_q.first()) {
-		do {
-			a_form->addItem(a_q.record().value("Klasse").toString());
-		} while (a_q.next());
+	if (!a_q.exec("SELECT DISTINCT `vajahr`, `kbuchst` FROM `schueler` WHERE `vajahr` IS NOT NULL "
+		      "ORDER BY `vajahr` DESC, `kbuchst`")) return;
+	while (a_q.next()) {
+		QString form = formName(a_q.value(0), a_q.value(1));
+		if (!forms.contains(form))
+			forms << form;
 	}
+	a_form->addItems(forms);
 }
 
 int ListView::m_calculateForm(QString form) {
@@ -336,13 +477,12 @@ int ListView::m_calculateForm(QString form) {
 /*!
  * \brief Lädt alles neu
  *
- * Zuerst werden die Klassen, dann die Tabellenheader und -daten neu geladen. Schließlich wird a_tableView angewiesen,
- * die Spalten nach Inhalt zu vergrößern/-kleinern.
+ * Die Tabellenheader und -daten werden im Hintergrund neu geladen. Sobald sie da sind, passt
+ * a_tableView die Spaltenbreiten an (siehe m_connectComponents()).
  */
 void ListView::refresh() {
 	a_tableModel->loadHeader();
 	a_tableModel->loadData();
-	a_tableView->resizeColumnsToContents();
 }
 
 /*!
@@ -363,49 +503,43 @@ void ListView::changeForm(QString form) {
 /*!
  * \brief Verbucht eine Bücherausleihe
  *
- * Erzeugt einen neuen InsertDialog im Schuljahresendmodus, führt ihn aus, löscht ihn
- * und lädt anschließend alles neu. Dabei wird dem Dialog ein Schüler-Datensatz übergeben, wenn ein Schüler ausgewählt war.
+ * Erzeugt einen neuen InsertDialog im Schuljahresendmodus, führt ihn aus und übernimmt die
+ * vom Dialog gemeldeten Ausgaben direkt ins Datenmodell, ohne die ganze Liste neu zu laden. Dabei wird dem Dialog ein Schüler-Datensatz übergeben, wenn ein Schüler ausgewählt war;
+ * dieser kommt aus dem Datenmodell, nicht aus der Datenbank.
  */
 void ListView::lendBook() {
+	TraceScope trace("action", "ListView::lendBook");
 	QSqlRecord r;
 	if (!a_tableView->selectionModel()->selectedRows().isEmpty()) {
 		int index = a_tableView->selectionModel()->selectedRows()[0].row();
-
-		a_q.prepare("SELECT * FROM `SSchueler` WHERE `Klasse`=:klasse AND `Name`=:name");
-		a_q.bindValue(":klasse", a_form->currentText());
-		a_q.bindValue(":name", a_tableModel->headerData(index, Qt::Vertical, Qt::DisplayRole));
-		if (!::exec_first(&a_q)) return;
-		r = a_q.record();
+		r = a_tableModel->record(index);
 	}
 	InsertDialog *dl = new InsertDialog(true, this, r);
 	dl->setFocus();
 	dl->exec();
+	a_tableModel->applyChanges(dl->changedLendings(), true);
 	delete dl;
-	refresh();
 }
 
 /*!
  * \brief Verbucht eine Bücherrückgabe
  *
- * Erzeugt einen neuen DeleteDialog im Schuljahresendmodus, führt ihn aus, löscht ihn wieder
- * und lädt anschließend alles neu. Dabei wird dem Dialog ein Schüler-Datensatz übergeben, wenn ein Schüler ausgewählt war.
+ * Erzeugt einen neuen DeleteDialog im Schuljahresendmodus, führt ihn aus und übernimmt die
+ * vom Dialog gemeldeten Rückgaben direkt ins Datenmodell, ohne die ganze Liste neu zu laden. Dabei wird dem Dialog ein Schüler-Datensatz übergeben, wenn ein Schüler ausgewählt war;
+ * dieser kommt aus dem Datenmodell, nicht aus der Datenbank.
  */
 void ListView::withdrawBook() {
+	TraceScope trace("action", "ListView::withdrawBook");
 	QSqlRecord r;
 	if (!a_tableView->selectionModel()->selectedRows().isEmpty()) {
 		int index = a_tableView->selectionModel()->selectedRows()[0].row();
-
-		a_q.prepare("SELECT * FROM `SSchueler` WHERE `Klasse` = :klasse AND `Name` = :name");
-		a_q.bindValue(":klasse", a_form->currentText());
-		a_q.bindValue(":name", a_tableModel->headerData(index, Qt::Vertical, Qt::DisplayRole).toString());
-		if (!::exec_first(&a_q)) return;
-		r = a_q.record();
+		r = a_tableModel->record(index);
 	}
 	DeleteDialog *dl = new DeleteDialog(true, this, r);
 	dl->setFocus();
 	dl->exec();
+	a_tableModel->applyChanges(dl->changedLendings(), false);
 	delete dl;
-	refresh();
 }
 
 /*!
@@ -437,3 +571,12 @@ void ListView::toggle() {
 void ListView::exportLendings() {
 	a_tableModel->exportData();
 }
+
+/*!
+ * \brief Passt die Spaltenbreiten an, sobald das Datenmodell geladen hat
+ *
+ * Die Breiten werden nur neu gemessen, wenn sich die Spalten (Bücher der Klasse) geändert haben.
+ */
+void ListView::fitColumns() {
+	a_sizer.fit(a_tableView);
+}
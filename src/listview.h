@@ -2,14 +2,18 @@
 #define LISTVIEW_H
 
 #include <QtContainerFwd>
+#include <QBitArray>
 #include <QWidget>
 #include <QTableWidget>
 #include <QAbstractTableModel>
 #include <QComboBox>
 #include <QPushButton>
 #include <QRadioButton>
-#include <QSqlQuery>
+#include "querystats.h"
+#include <QSqlRecord>
 #include <QProxyStyle>
+#include "executor.h"
+#include "columnsizer.h"
 
 /*!
  * \brief Der Proxy-Style, mithilfe dessen die Bücher in der Listenansicht um 270 Grad rotiert werden
@@ -27,14 +31,23 @@ class ListModel : public QAbstractTableModel {
 	Q_OBJECT
 private:
 	QString a_form;                          ///< Klasse, die angezeigt werden soll
-	QMap<QString, int> a_students;           ///< Zuordnung Schüler->SId
-	QList<int> a_showed;                     ///< Zuordnung Zeile->SId
-	QMap<QString, QString> a_books;          ///< Zuordnung Titel->ISBN
-	QHash<int, bool> a_free;                      ///< Zuordnung SId -> hat noch Bücher zurückzugeben
-	QHash<int, QHash<QString, bool>> a_lent; ///< Liste der Ausleihen
-	int a_numStudents;                       ///< Anzahl der Schüler
+	QVector<int> a_studentIds;               ///< Zuordnung Zeile->SId
+	QStringList a_studentNames;              ///< Zuordnung Zeile->Name
+	QHash<int, int> a_studentRows;           ///< Zuordnung SId->Zeile
+	QStringList a_bookIsbns;                 ///< Zuordnung Spalte->ISBN
+	QStringList a_bookTitles;                ///< Zuordnung Spalte->Titel
+	QHash<QString, int> a_bookColumns;       ///< Zuordnung ISBN->Spalte
+	QBitArray a_lent;                        ///< Zeilenweise Bitmatrix der Ausgaben (Schüler x Bücher)
+	QBitArray a_free;                        ///< Zuordnung Zeile->hat keine Bücher mehr zurückzugeben
 	int a_displayedForm;                     ///< Jgst, deren Bücher anzuzeigen sind
-	QSqlQuery a_q;                           ///< Zu verwendendes QSqlQuery-Objekt
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
+	int a_headerTicket;                      ///< Auftrag des ausstehenden loadHeader()
+	int a_dataTicket;                        ///< Auftrag des ausstehenden loadData()
+
+	void m_applyHeader(const QueryResult &result);
+	void m_applyData(const QueryResult &result);
+	bool m_isLent(int row, int column) const {return a_lent.testBit(row * a_bookIsbns.size() + column);}
+	bool m_isFree(int sid);
 
 public:
 	ListModel(QObject *parent = 0);
@@ -44,10 +57,18 @@ public:
 	int columnCount(const QModelIndex &) const;
 	void loadHeader();
 	void loadData();
+	void applyChanges(const QList<QPair<int, QString>> &changes, bool lent);
 	void exportData();
 	void setForm(QString form);
 	QString form() {return a_form;}
+	QSqlRecord record(int row) const;
 	void setDisplayedForm(int form);
+
+private slots:
+	void loadResult(QueryResult result);
+
+signals:
+	void loaded();
 };
 
 class ListTable : public QTableView {
@@ -69,7 +90,8 @@ private:
 	QComboBox *a_form;                       ///< Dient zur Auswahl der Klasse
 	QRadioButton *a_newList;                 ///< Gibt an, ob die neue Liste angezeigt wird
 	QRadioButton *a_oldList;                 ///< Gibt an, ob die alte Liste angezeigt wird
-	QSqlQuery a_q;                           ///< Zu verwendendes QSqlQuery-Objekt
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
+	ColumnSizer a_sizer;                     ///< Passt die Spaltenbreiten der Tabelle an
 
 	void m_populateCombo();
 	void m_createComponents();
@@ -84,6 +106,7 @@ public:
 private slots:
 	void changeForm(QString form);
 	void toggle();
+	void fitColumns();
 
 public slots:
 	void refresh();
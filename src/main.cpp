@@ -1,8 +1,15 @@
 #include "view.h"
+#include "executor.h"
+#include "bookindex.h"
+#include "personindex.h"
+#include "migrator.h"
+#include "watchdog.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <QtSql>
 #include <QDebug>
+#include <QDir>
+#include <QCommandLineParser>
 
 QString APP_NAME = "Obsidian";
 QString ORG_NAME = "Philip Schlösser";
@@ -16,6 +23,10 @@ QString DB_PASSWORD = "Buecherverwaltungsprogramm";
 QString DB_NAME = "biblio";
 QString PDF_VIEWER = "/usr/bin/evince";
 QString DOC_FILE = "/usr/share/doc/Obsidian/doc.pdf";
+int SLOW_QUERY_MS = 250;
+QString SLOW_QUERY_LOG = QDir::home().filePath(".obsidian-slow.log");
+QString TRACE_FILE = "";
+int STALL_MS = 500;
 
 QBrush STUDENT_FREE = QBrush(QColor(127, 255, 127));
 
@@ -27,7 +38,17 @@ QBrush STUDENT_FREE = QBrush(QColor(127, 255, 127));
  * schließlich wird der Fehlertext inkl. Fehlernummer in Form einer QMessageBox ausgegeben.
  */
 void sqlError(QSqlQuery query) {
-	QSqlError e = query.lastError();
+	sqlError(query.lastError(), query.lastQuery());
+}
+
+/*!
+ * \brief Gibt eine Fehlermeldung aus
+ * \param e Aufgetretener Fehler
+ * \param query Abfrage, bei der der Fehler geschah
+ *
+ * Wird für Fehler verwendet, die nicht mehr an einem QSqlQuery-Objekt hängen, z.B. aus dem QueryExecutor.
+ */
+void sqlError(QSqlError e, QString query) {
 	switch(e.number()) {
 	case 1451:
 		QMessageBox::critical(0, "Fehler", "Datensatz kann nicht gelöscht oder geändert "
@@ -38,7 +59,7 @@ void sqlError(QSqlQuery query) {
 				      "werden,\nda Schüler/Lehrer/Buch noch nicht existiert! - 1452");
 		break;
 	default:
-		QMessageBox::information(0, "Sql-Abfrage", query.lastQuery());
+		QMessageBox::information(0, "Sql-Abfrage", query);
 		QMessageBox::critical(0, "Fehler", QString("%1 - %2").arg(e.text()).arg(e.number()));
 		break;
 	}
@@ -47,12 +68,12 @@ void sqlError(QSqlQuery query) {
 /*!
  * \brief Helferfunktion für die Ausführung einer SQL-Abfrage
  * \param query SQL-Abfrage
- * \param qObj QSqlQuery-Objekt, mit dem die Abfrage ausgeführt werden soll
+ * \param qObj TimedQuery-Objekt, mit dem die Abfrage ausgeführt werden soll
  * \return true - Abfrage erfolgreich, false - Fehler
  *
  * Diese Funktion dient dazu, eine Abfrage auszuführen und ggf. die Abfrage ausgeben.
  */
-bool exec(QString query, QSqlQuery q) {
+bool exec(QString query, TimedQuery q) {
 	return q.exec(query);
 }
 
@@ -89,6 +110,100 @@ QString escape(QString par) {
 	return res;
 }
 
+/*!
+ * \brief Erzeugt eine Liste durchnummerierter Platzhalter, z.B. für IN (...)
+ * \param name Name der Platzhalter inkl. Doppelpunkt
+ * \param count Anzahl der Platzhalter
+ * \return z.B. ":bid0, :bid1, :bid2" für name = ":bid" und count = 3
+ */
+QString placeholders(QString name, int count) {
+	QStringList list;
+	for (int i = 0; i < count; ++i)
+		list << QString("%1%2").arg(name).arg(i);
+	return list.join(", ");
+}
+
+/*!
+ * \brief Vereinheitlicht einen Text für Vergleiche
+ * \param text Text
+ * \return Text ohne Groß-/Kleinschreibung, ß als ss und Umlaute bzw. Akzente als Grundbuchstaben (DIN 5007)
+ */
+QString fold(QString text) {
+	text = text.toCaseFolded().replace(QChar(0x00df), "ss").normalized(QString::NormalizationForm_D);
+	QString result;
+	result.reserve(text.size());
+	for (int i = 0; i < text.size(); ++i)
+		if (text[i].category() != QChar::Mark_NonSpacing)
+			result += text[i];
+	return result;
+}
+
+static qint64 s_serverOffset = 0;        ///< Sekunden, die die Uhr des Datenbankservers der eigenen voraus ist
+
+/*!
+ * \brief Gleicht die Uhr mit der des Datenbankservers ab
+ * \param db Geöffnete Datenbankverbindung
+ *
+ * klasse_berechnen() rechnet mit CURDATE() des Servers. Damit formName() und formFilter() um den 1. September
+ * herum dieselben Klassen ergeben wie der View `SSchueler`, wird der Abstand zur Serveruhr einmal ermittelt und
+ * in schoolYearSum() berücksichtigt. Schlägt die Abfrage fehl, gilt die eigene Uhr.
+ */
+void syncServerClock(QSqlDatabase db) {
+	QSqlQuery q(db);
+	if (q.exec("SELECT NOW()") && q.next())
+		s_serverOffset = QDateTime::currentDateTime().secsTo(q.value(0).toDateTime());
+}
+
+/*!
+ * \brief Gibt die Summe aus Jahrgangsstufe und Abschlussjahr im laufenden Schuljahr zurück
+ *
+ * Wie in klasse_berechnen() beginnt das neue Schuljahr im September; maßgeblich ist das Datum des
+ * Datenbankservers (siehe syncServerClock()).
+ */
+int schoolYearSum() {
+	QDate today = QDateTime::currentDateTime().addSecs(s_serverOffset).date();
+	return (today.month() >= 9 ? 13 : 12) + today.year();
+}
+
+/*!
+ * \brief Berechnet die Klasse eines Schülers wie klasse_berechnen() in der Datenbank
+ * \param vajahr Abschlussjahr oder NULL
+ * \param kbuchst Klassenbuchstabe oder NULL
+ * \return z.B. "7b"; "" wenn kein Abschlussjahr bekannt ist (wie der View `SSchueler`)
+ */
+QString formName(QVariant vajahr, QVariant kbuchst) {
+	if (vajahr.isNull())
+		return QString();
+	return QString::number(schoolYearSum() - vajahr.toInt()) + kbuchst.toString();
+}
+
+/*!
+ * \brief Erzeugt die Bedingung für alle Schüler einer Klasse
+ * \param form Klasse wie von formName(), z.B. "7b" oder "11"
+ * \param table Tabelle bzw. Alias von `schueler` (mit Backticks) oder ""
+ * \return Bedingung auf `vajahr` und `kbuchst` in Klammern; "FALSE" bei einer ungültigen Klasse
+ *
+ * Die Klasse wird hier in Abschlussjahr und Klassenbuchstaben umgerechnet, statt in der Datenbank für jede
+ * Zeile klasse_berechnen() aufzurufen. So kann der Index auf (`vajahr`, `kbuchst`) benutzt werden.
+ */
+QString formFilter(QString form, QString table) {
+	QString prefix = table.isEmpty() ? QString() : table + ".";
+	form = form.simplified();
+	int digits = 0;
+	while (digits < form.size() && form[digits].isDigit())
+		++digits;
+	if (digits == 0)
+		return "FALSE";
+
+	QString letter = form.mid(digits);
+	QString filter = QString("(%1`vajahr` = %2 AND ").arg(prefix).arg(schoolYearSum() - form.left(digits).toInt());
+	if (letter.isEmpty())
+		filter += QString("(%1`kbuchst` IS NULL OR %1`kbuchst` = ''))").arg(prefix);
+	else
+		filter += QString("%1`kbuchst` = '%2')").arg(prefix).arg(escape(letter));
+	return filter;
+}
+
 /*!
  * \brief Helferfunktion für die Ausführung eines Prepared Statements
  * \param q Enthält das Statement
@@ -96,7 +211,7 @@ QString escape(QString par) {
  *
  * Das Prepared Statement wird ausgeführt und im Falle eines Fehlers sqlError() aufgerufen.
  */
-bool exec(QSqlQuery &q) {
+bool exec(TimedQuery &q) {
 	bool b = q.exec();
 	if (!b)
 		sqlError(q);
@@ -108,7 +223,7 @@ bool exec(QSqlQuery &q) {
  * \param q Enthält das Statement
  * \return true - alles erfolgreich
  */
-bool exec_first(QSqlQuery *q) {
+bool exec_first(TimedQuery *q) {
 	if (!q->exec()) {
 		sqlError(*q);
 		return false;
@@ -132,6 +247,14 @@ void load_settings() {
 		settings.setValue("allg/pdf-viewer", PDF_VIEWER);
 	if (!settings.contains("allg/doc"))
 		settings.setValue("allg/doc", DOC_FILE);
+	if (!settings.contains("diag/slow-query-ms"))
+		settings.setValue("diag/slow-query-ms", SLOW_QUERY_MS);
+	if (!settings.contains("diag/slow-query-log"))
+		settings.setValue("diag/slow-query-log", SLOW_QUERY_LOG);
+	if (!settings.contains("diag/trace-file"))
+		settings.setValue("diag/trace-file", TRACE_FILE);
+	if (!settings.contains("diag/stall-ms"))
+		settings.setValue("diag/stall-ms", STALL_MS);
 	DB_PORT = settings.value("db/port").toInt();
 	DB_IP = settings.value("db/ip").toString();
 	DB_NAME = settings.value("db/name").toString();
@@ -139,16 +262,28 @@ void load_settings() {
 	DB_PASSWORD = settings.value("db/pwd").toString();
 	PDF_VIEWER = settings.value("allg/pdf-viewer").toString();
 	DOC_FILE = settings.value("allg/doc").toString();
+	SLOW_QUERY_MS = settings.value("diag/slow-query-ms").toInt();
+	SLOW_QUERY_LOG = settings.value("diag/slow-query-log").toString();
+	TRACE_FILE = settings.value("diag/trace-file").toString();
+	STALL_MS = settings.value("diag/stall-ms").toInt();
 }
 
+#ifndef OBSIDIAN_BENCHMARK
 /*!
  * \brief Hauptprogramm
  * \param argc Anzahl der Argumente
  * \param argv Argumente in Form eines char **
  * \return 0 im Falle eines Erfolgs
  *
- * Zuerst wird das Textformat auf UTF-8 gesetzt, dann die Datenbankverbindung aufgebaut
- * und schließlich das Hauptfenster instanziiert und angezeigt.
+ * Zuerst wird das Textformat auf UTF-8 gesetzt. Dann werden ggf. der Tracer (Einstellung diag/trace-file
+ * oder --trace <datei>) und die Zeitmessung der Statements (QueryStats) eingerichtet. Anschließend wird die
+ * Datenbankverbindung aufgebaut, die Uhr mit dem Server abgeglichen und das Schema ggf. migriert (siehe
+ * Migrator). Danach werden der QueryExecutor für Abfragen im Hintergrund gestartet und das Laden von BookIndex
+ * und PersonIndex angestoßen. Schließlich wird das Hauptfenster instanziiert und angezeigt. Erst dann beginnt
+ * der Watchdog, damit der Programmstart nicht als Hänger zählt.
+ *
+ * Die Benchmarks (bench/bench.pro) übersetzen diese Datei mit OBSIDIAN_BENCHMARK und bringen ihr eigenes
+ * main() mit.
  */
 int main(int argc, char *argv[])
 {
@@ -160,6 +295,14 @@ int main(int argc, char *argv[])
 	QCoreApplication::setOrganizationDomain(ORG_DOMAIN);
 
 	load_settings();
+	QCommandLineParser parser;
+	QCommandLineOption trace("trace", "Schreibt eine Zeitleiste im Trace-Event-Format nach <datei>.", "datei");
+	parser.addOption(trace);
+	parser.parse(a.arguments());
+	if (parser.isSet(trace))
+		TRACE_FILE = parser.value(trace);
+	QScopedPointer<Tracer> tracer(TRACE_FILE.isEmpty() ? 0 : new Tracer(TRACE_FILE));
+	QueryStats stats(SLOW_QUERY_LOG, SLOW_QUERY_MS);
 	QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL");
 	db.setPort(DB_PORT);
 	db.setHostName(DB_IP);
@@ -171,10 +314,21 @@ int main(int argc, char *argv[])
 	if (!ok) {
 	  QMessageBox::critical(NULL, "Fehler", db.lastError().text());
 	}
+	else {
+		syncServerClock(db);
+		Migrator(db).run();
+	}
+	QueryExecutor executor;
+	BookIndex books;
+	books.reload();
+	PersonIndex people;
+	people.reload();
 	a.setWindowIcon(QIcon(":images/icon.png"));
 	View *v = new View;
 	v->setAttribute(Qt::WA_QuitOnClose, true);
 	v->setWindowState(Qt::WindowMaximized);
 	v->show();
+	QScopedPointer<Watchdog> watchdog(STALL_MS > 0 ? new Watchdog(SLOW_QUERY_LOG, STALL_MS) : 0);
 	return a.exec();
 }
+#endif
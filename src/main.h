@@ -1,14 +1,25 @@
 #ifndef MAIN_H
 #define MAIN_H
-#include <QSqlQuery>
+#include "querystats.h"
+#include "tracer.h"
+#include <QSqlError>
+#include <QSqlDatabase>
 #include <QString>
+#include <QVariant>
 #include <QBrush>
 
 void sqlError(QSqlQuery query);
-bool exec(QSqlQuery &q);
-bool exec(QString query, QSqlQuery q);
-bool exec_first(QSqlQuery *q);
+void sqlError(QSqlError e, QString query);
+bool exec(TimedQuery &q);
+bool exec(QString query, TimedQuery q);
+bool exec_first(TimedQuery *q);
 QString escape(QString par);
+QString placeholders(QString name, int count);
+QString fold(QString text);
+void syncServerClock(QSqlDatabase db);
+int schoolYearSum();
+QString formName(QVariant vajahr, QVariant kbuchst);
+QString formFilter(QString form, QString table = QString());
 void load_settings();
 
 extern QString APP_NAME;
@@ -23,6 +34,10 @@ extern QString DB_PASSWORD;
 extern QString DB_NAME;
 extern QString PDF_VIEWER;
 extern QString DOC_FILE;
+extern int SLOW_QUERY_MS;
+extern QString SLOW_QUERY_LOG;
+extern QString TRACE_FILE;
+extern int STALL_MS;
 
 extern QBrush STUDENT_FREE;
 #endif
@@ -0,0 +1,158 @@
+#include "migrator.h"
+#include "main.h"
+#include <QVariant>
+#include <QMessageBox>
+
+/*!
+ * \brief Konstruktor von Migrator
+ * \param db Geöffnete Datenbankverbindung
+ */
+Migrator::Migrator(QSqlDatabase db) : a_db(db), a_q(db) {
+	m_addMigrations();
+}
+
+/*!
+ * \brief Legt die Liste der Migrationen an
+ *
+ * Neue Migrationen werden nur hinten angehängt; bereits ausgelieferte dürfen nicht mehr verändert werden.
+ */
+void Migrator::m_addMigrations() {
+	Migration m;
+
+	m.version = 1;
+	m.description = "Indizes für Klassen, Namen und Ausleihdaten";
+	m.steps << Step("schueler", "klasse", QStringList()
+			<< "ALTER TABLE `schueler` ADD KEY `klasse` (`vajahr`, `kbuchst`)")
+		<< Step("schueler", "name", QStringList()
+			<< "ALTER TABLE `schueler` ADD KEY `name` (`name`)")
+		<< Step("sausleihe", "adatum", QStringList()
+			<< "ALTER TABLE `sausleihe` ADD KEY `adatum` (`adatum`)")
+		<< Step("lausleihe", "adatum", QStringList()
+			<< "ALTER TABLE `lausleihe` ADD KEY `adatum` (`adatum`)")
+		<< Step("btausch", "datum", QStringList()
+			<< "ALTER TABLE `btausch` ADD KEY `datum` (`datum`)");
+	a_migrations << m;
+
+	m = Migration();
+	m.version = 2;
+	m.description = "FULLTEXT-Indizes (ngram) für die Suche nach Namen und Titeln";
+	foreach (QString table, QStringList() << "schueler" << "lehrer" << "buch")
+		m.steps << Step(table, "ft_name", QStringList()
+				<< "SET SESSION innodb_ft_enable_stopword = OFF"
+				<< QString("ALTER TABLE `%1` ADD FULLTEXT KEY `ft_name` (`name`) WITH PARSER ngram")
+				   .arg(table));
+	a_migrations << m;
+}
+
+/*!
+ * \brief Gibt die Nummer der zuletzt angewendeten Migration zurück
+ * \return Nummer, 0 bei einer neuen Datenbank oder -1 bei einem Fehler
+ *
+ * `schema_version` wird nur angelegt, wenn es die Tabelle noch nicht gibt; ist das Schema aktuell, genügt
+ * also das SELECT-Recht.
+ */
+int Migrator::m_currentVersion() {
+	if (!a_q.exec("SELECT COUNT(*) FROM `information_schema`.`TABLES` WHERE `TABLE_SCHEMA` = DATABASE() "
+		      "AND `TABLE_NAME` = 'schema_version'") || !a_q.next()) {
+		sqlError(a_q);
+		return -1;
+	}
+	if (a_q.value(0).toInt() == 0 && !a_q.exec("CREATE TABLE `schema_version` (`version` int(11) NOT NULL, "
+						   "`beschreibung` varchar(100) NOT NULL, `angewendet` datetime NOT NULL, "
+						   "PRIMARY KEY (`version`)) ENGINE=InnoDB DEFAULT CHARSET=utf8")) {
+		sqlError(a_q);
+		return -1;
+	}
+	if (!a_q.exec("SELECT IFNULL(MAX(`version`), 0) FROM `schema_version`") || !a_q.next()) {
+		sqlError(a_q);
+		return -1;
+	}
+	return a_q.value(0).toInt();
+}
+
+/*!
+ * \brief Prüft, ob ein Index existiert
+ * \param table Tabelle
+ * \param index Name des Index
+ * \return true - Index existiert (bei einem Fehler false, der Schritt schlägt dann selbst fehl)
+ */
+bool Migrator::m_indexExists(QString table, QString index) {
+	a_q.prepare("SELECT COUNT(*) FROM `information_schema`.`STATISTICS` WHERE `TABLE_SCHEMA` = DATABASE() "
+		    "AND `TABLE_NAME` = :table AND `INDEX_NAME` = :index");
+	a_q.bindValue(":table", table);
+	a_q.bindValue(":index", index);
+	return a_q.exec() && a_q.next() && a_q.value(0).toInt() > 0;
+}
+
+/*!
+ * \brief Wendet eine Migration an
+ * \param m Migration
+ * \return true - Migration wurde vollständig angewendet und eingetragen
+ *
+ * DDL-Statements beenden in MySQL jede Transaktion, deshalb kann nur der Eintrag in `schema_version` in
+ * einer Transaktion geschehen. Bricht eine Migration ab, sorgen die Prüfungen in m_indexExists() dafür, dass
+ * sie beim nächsten Start an der richtigen Stelle fortgesetzt wird.
+ */
+bool Migrator::m_apply(const Migration &m) {
+	foreach (const Step &s, m.steps) {
+		if (m_indexExists(s.table, s.index))
+			continue;
+		foreach (const QString &sql, s.sql) {
+			if (!a_q.exec(sql)) {
+				sqlError(a_q);
+				return false;
+			}
+		}
+	}
+
+	a_db.transaction();
+	a_q.prepare("INSERT INTO `schema_version` VALUES (:version, :description, NOW())");
+	a_q.bindValue(":version", m.version);
+	a_q.bindValue(":description", m.description);
+	if (!a_q.exec()) {
+		sqlError(a_q);
+		a_db.rollback();
+		return false;
+	}
+	if (!a_db.commit()) {
+		sqlError(a_db.lastError(), "COMMIT");
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * \brief Wendet alle noch ausstehenden Migrationen an
+ * \return true - Das Schema ist auf dem aktuellen Stand
+ *
+ * Damit nicht zwei gleichzeitig gestartete Programme dieselbe Migration ausführen, wird eine benannte Sperre
+ * gehalten. Wer sie nicht binnen 30 Sekunden bekommt, wird gefragt, ob er es erneut versuchen oder mit dem alten
+ * Schema weiterarbeiten will. Fehlen dem Benutzer die Rechte (ALTER, CREATE, INDEX), wird der Fehler angezeigt
+ * und das Programm läuft ebenfalls mit dem alten Schema weiter.
+ */
+bool Migrator::run() {
+	while (true) {
+		if (!a_q.exec("SELECT GET_LOCK('obsidian_schema', 30)") || !a_q.next()) {
+			sqlError(a_q);
+			return false;
+		}
+		if (a_q.value(0).toInt() == 1)
+			break;
+		if (QMessageBox::critical(0, "Fehler", "Das Datenbankschema kann nicht aktualisiert werden, da gerade "
+					  "ein anderes Programm die Datenbank migriert.\nErneut versuchen? Sonst wird mit "
+					  "dem alten Schema weitergearbeitet.", QMessageBox::Retry | QMessageBox::Ignore,
+					  QMessageBox::Retry) != QMessageBox::Retry)
+			return false;
+	}
+
+	bool ok = true;
+	int current = m_currentVersion();
+	if (current < 0)
+		ok = false;
+	for (int i = 0; ok && i < a_migrations.size(); ++i)
+		if (a_migrations[i].version > current)
+			ok = m_apply(a_migrations[i]);
+
+	a_q.exec("SELECT RELEASE_LOCK('obsidian_schema')");
+	return ok;
+}
@@ -0,0 +1,52 @@
+#ifndef MIGRATOR_H
+#define MIGRATOR_H
+
+#include <QSqlDatabase>
+#include "querystats.h"
+#include <QStringList>
+#include <QList>
+
+/*!
+ * \brief Bringt das Datenbankschema beim Programmstart auf den aktuellen Stand
+ *
+ * Die Migrationen sind fortlaufend nummeriert; in `schema_version` steht, welche schon angewendet wurden.
+ * Jeder Schritt einer Migration prüft vorher in information_schema, ob er nötig ist, sodass auch
+ * Datenbanken, die mit einem neueren buecher.sql angelegt wurden, nur noch die Versionsnummer erhalten.
+ */
+class Migrator {
+private:
+	/*!
+	 * \brief Ein Schritt einer Migration: ein Index, der angelegt wird, falls er noch fehlt
+	 */
+	struct Step {
+		QString table;                   ///< Tabelle
+		QString index;                   ///< Name des Index
+		QStringList sql;                 ///< Statements, die den Index anlegen
+
+		Step(QString t, QString i, QStringList s) : table(t), index(i), sql(s) {}
+	};
+
+	/*!
+	 * \brief Eine Migration
+	 */
+	struct Migration {
+		int version;                     ///< Fortlaufende Nummer
+		QString description;             ///< Beschreibung für `schema_version`
+		QList<Step> steps;               ///< Schritte in der auszuführenden Reihenfolge
+	};
+
+	QSqlDatabase a_db;                       ///< Datenbankverbindung
+	TimedQuery a_q;                          ///< Zu verwendendes QSqlQuery-Objekt (mit Zeitmessung)
+	QList<Migration> a_migrations;           ///< Alle Migrationen, aufsteigend nummeriert
+
+	void m_addMigrations();
+	int m_currentVersion();
+	bool m_indexExists(QString table, QString index);
+	bool m_apply(const Migration &m);
+
+public:
+	Migrator(QSqlDatabase db);
+	bool run();
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include "pagedmodel.h"
+#include "main.h"
+
+/*!
+ * \brief Konstruktor von PagedModel
+ * \param parent Elternobjekt
+ *
+ * Verbindet das Modell mit dem QueryExecutor, damit es seine Seiten erhält.
+ */
+PagedModel::PagedModel(QObject *parent) : QAbstractTableModel(parent), a_sortColumn(-1),
+	a_sortOrder(Qt::AscendingOrder), a_atEnd(true), a_estimate(-1), a_ticket(0), a_first(false) {
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(loadResult(QueryResult)));
+}
+
+/*!
+ * \brief Setzt die Abfrage
+ * \param columns Ausdrücke der angezeigten Spalten
+ * \param from Tabellen inkl. Joins (ohne "FROM")
+ * \param keys Ausdrücke, die zusammen eine Zeile eindeutig bestimmen (z.B. der Primärschlüssel)
+ * \param table Haupttabelle, deren Zeilenzahl ohne Filter als Schätzung dient
+ */
+void PagedModel::setStatement(QStringList columns, QString from, QStringList keys, QString table) {
+	a_columns = columns;
+	a_from = from;
+	a_keys = keys;
+	a_table = table;
+}
+
+/*!
+ * \brief Setzt die WHERE-Bedingung
+ * \param filter Bedingung ohne "WHERE" oder ""
+ *
+ * Wie bei QSqlTableModel muss anschließend select() aufgerufen werden.
+ */
+void PagedModel::setFilter(QString filter) {
+	a_filter = filter;
+}
+
+/*!
+ * \brief Setzt die Sortierung und lädt die Daten neu
+ * \param column Spalte, nach der sortiert wird
+ * \param order Reihenfolge
+ */
+void PagedModel::sort(int column, Qt::SortOrder order) {
+	a_sortColumn = column;
+	a_sortOrder = order;
+	select();
+}
+
+/*!
+ * \brief Setzt die Abfrage der nächsten Seite zusammen
+ * \return Abfrage mit den Werten der letzten geladenen Zeile
+ *
+ * Die Zeilen sind nach der Sortierspalte und danach nach den Schlüsseln geordnet. Die nächste Seite beginnt
+ * hinter der letzten geladenen Zeile. NULL steht bei MySQL aufsteigend vor, absteigend hinter allen Werten.
+ */
+QueryRequest PagedModel::m_page() const {
+	QueryRequest r;
+	QStringList where;
+	bool asc = a_sortOrder == Qt::AscendingOrder;
+	QString dir = asc ? "ASC" : "DESC";
+	QStringList order;
+
+	if (!a_filter.isEmpty())
+		where << QString("(%1)").arg(a_filter);
+	if (a_sortColumn >= 0)
+		order << QString("%1 %2").arg(a_columns[a_sortColumn]).arg(dir);
+	foreach (const QString &key, a_keys)
+		order << QString("%1 %2").arg(key).arg(dir);
+
+	if (!a_rows.isEmpty()) {
+		QString tie = QString("(%1) %2 (%3)").arg(a_keys.join(", ")).arg(asc ? ">" : "<")
+				.arg(placeholders(":key", a_keys.size()));
+		for (int i = 0; i < a_lastKeys.size(); ++i)
+			r.values[QString(":key%1").arg(i)] = a_lastKeys[i];
+		if (a_sortColumn < 0) {
+			where << tie;
+		} else {
+			QString e = a_columns[a_sortColumn];
+			if (a_lastSort.isNull()) {
+				where << (asc ? QString("(%1 IS NOT NULL OR (%1 IS NULL AND %2))").arg(e).arg(tie)
+					      : QString("(%1 IS NULL AND %2)").arg(e).arg(tie));
+			} else {
+				where << (asc ? QString("(%1 > :last0 OR (%1 = :last1 AND %2))").arg(e).arg(tie)
+					      : QString("(%1 < :last0 OR %1 IS NULL OR (%1 = :last1 AND %2))").arg(e).arg(tie));
+				r.values[":last0"] = a_lastSort;
+				r.values[":last1"] = a_lastSort;
+			}
+		}
+	}
+
+	r.sql = QString("SELECT %1, %2 FROM %3").arg(a_columns.join(", ")).arg(a_keys.join(", ")).arg(a_from);
+	if (!where.isEmpty())
+		r.sql += QString(" WHERE %1").arg(where.join(" AND "));
+	r.sql += QString(" ORDER BY %1 LIMIT %2").arg(order.join(", ")).arg(a_pageSize);
+	return r;
+}
+
+/*!
+ * \brief Setzt die Abfrage für die Schätzung der Zeilenzahl zusammen
+ * \return Abfrage, die eine einzige Zahl liefert
+ *
+ * Ohne Filter wird die von InnoDB geführte Schätzung aus information_schema benutzt, die keinen Tabellenscan
+ * erfordert. Mit Filter ist die Ergebnismenge meist klein, dann wird genau gezählt.
+ */
+QueryRequest PagedModel::m_estimate() const {
+	QueryRequest r;
+	if (a_filter.isEmpty()) {
+		r.sql = "SELECT `TABLE_ROWS` FROM `information_schema`.`TABLES` "
+			"WHERE `TABLE_SCHEMA` = DATABASE() AND `TABLE_NAME` = :table";
+		r.values[":table"] = a_table;
+	} else {
+		r.sql = QString("SELECT COUNT(*) FROM %1 WHERE %2").arg(a_from).arg(a_filter);
+	}
+	return r;
+}
+
+/*!
+ * \brief Verwirft die geladenen Zeilen und lädt die erste Seite im Hintergrund
+ *
+ * Ein noch ausstehender Auftrag dieses Modells wird dabei verworfen.
+ */
+void PagedModel::select() {
+	beginResetModel();
+	a_rows.clear();
+	a_lastSort = QVariant();
+	a_lastKeys.clear();
+	a_atEnd = false;
+	endResetModel();
+
+	a_first = true;
+	a_ticket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "page"),
+						      QList<QueryRequest>() << m_page() << m_estimate());
+}
+
+/*!
+ * \brief Gibt an, ob es noch weitere Seiten gibt
+ */
+bool PagedModel::canFetchMore(const QModelIndex &parent) const {
+	return !parent.isValid() && !a_atEnd;
+}
+
+/*!
+ * \brief Lädt die nächste Seite im Hintergrund
+ *
+ * Wird von der Ansicht aufgerufen, sobald ans Ende gescrollt wurde. Läuft bereits ein Auftrag, passiert nichts.
+ */
+void PagedModel::fetchMore(const QModelIndex &parent) {
+	if (parent.isValid() || a_atEnd || a_ticket != 0)
+		return;
+	a_first = false;
+	a_ticket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "page"), m_page());
+}
+
+/*!
+ * \brief Übernimmt eine geladene Seite
+ * \param result Ergebnis eines beliebigen Auftrags
+ */
+void PagedModel::loadResult(QueryResult result) {
+	if (result.ticket != a_ticket)
+		return;
+	a_ticket = 0;
+	if (!result.ok()) {
+		a_atEnd = true;
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+
+	const QueryResultSet &page = result.sets[0];
+	int columns = a_columns.size();
+	a_atEnd = page.rows.size() < a_pageSize;
+	if (!page.rows.isEmpty()) {
+		beginInsertRows(QModelIndex(), a_rows.size(), a_rows.size() + page.rows.size() - 1);
+		a_rows.reserve(a_rows.size() + page.rows.size());
+		foreach (const QVariantList &row, page.rows)
+			a_rows.append(row.mid(0, columns));
+		endInsertRows();
+		const QVariantList &last = page.rows.last();
+		a_lastSort = a_sortColumn >= 0 ? last[a_sortColumn] : QVariant();
+		a_lastKeys = last.mid(columns);
+	}
+
+	if (a_first && result.sets.size() > 1 && !result.sets[1].rows.isEmpty()) {
+		a_estimate = result.sets[1].rows[0].value(0).toInt();
+		emit estimated(a_estimate);
+	}
+	emit loaded();
+}
+
+/*!
+ * \brief Gibt den Inhalt einer Zelle aus
+ * \param index Zelle
+ * \param role Art der Daten
+ * \return Inhalt der Zelle bei Qt::DisplayRole und Qt::EditRole, sonst QVariant()
+ */
+QVariant PagedModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+		return QVariant();
+	return a_rows[index.row()].value(index.column());
+}
+
+/*!
+ * \brief Gibt die Spaltenüberschriften aus
+ * \param section Spalte/Zeile
+ * \param orientation Horizontaler oder vertikaler Header
+ * \param role Art der Daten
+ * \return Gesetzte Überschrift, sonst der Spaltenausdruck
+ */
+QVariant PagedModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+		if (a_headers.contains(section))
+			return a_headers[section];
+		if (section < a_columns.size())
+			return a_columns[section];
+	}
+	return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+/*!
+ * \brief Setzt eine Spaltenüberschrift
+ * \return true - Überschrift wurde gesetzt
+ */
+bool PagedModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role) {
+	if (orientation != Qt::Horizontal || (role != Qt::EditRole && role != Qt::DisplayRole))
+		return false;
+	a_headers[section] = value;
+	emit headerDataChanged(orientation, section, section);
+	return true;
+}
+
+/*!
+ * \brief Gibt die Anzahl der bisher geladenen Zeilen an
+ */
+int PagedModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : a_rows.size();
+}
+
+/*!
+ * \brief Gibt die Anzahl der Spalten an
+ */
+int PagedModel::columnCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : a_columns.size();
+}
@@ -0,0 +1,67 @@
+#ifndef PAGEDMODEL_H
+#define PAGEDMODEL_H
+
+#include "executor.h"
+#include <QAbstractTableModel>
+#include <QStringList>
+
+/*!
+ * \brief Nur lesbares Datenmodell, das seine Daten seitenweise im Hintergrund nachlädt
+ *
+ * Es werden immer nur a_pageSize Zeilen auf einmal abgefragt; weitere Seiten werden über fetchMore()
+ * geladen, wenn in der Ansicht ans Ende gescrollt wird. Die Seiten werden nicht mit OFFSET, sondern über
+ * die Werte der letzten Zeile (Sortierspalte und eindeutiger Schlüssel) abgegrenzt. Ohne Sortierspalte oder
+ * bei einer Spalte mit Index lesen so auch späte Seiten nur so viele Zeilen, wie sie liefern. Wird nach einer
+ * berechneten Spalte sortiert (z.B. `Klasse` aus klasse_berechnen() oder `titel` aus dem View `Buch`), muss
+ * der Server dagegen für jede Seite den ganzen Join auswerten und sortieren. Filter und Sortierung
+ * funktionieren wie bei ResultModel.
+ */
+class PagedModel : public QAbstractTableModel {
+	Q_OBJECT
+private:
+	static constexpr int a_pageSize = 500;   ///< Anzahl der Zeilen pro Seite
+	QStringList a_columns;                   ///< Ausdrücke der angezeigten Spalten
+	QStringList a_keys;                      ///< Ausdrücke, die eine Zeile eindeutig bestimmen
+	QString a_from;                          ///< Tabellen der Abfrage inkl. Joins
+	QString a_table;                         ///< Haupttabelle für die Schätzung der Zeilenzahl
+	QString a_filter;                        ///< WHERE-Bedingung ohne "WHERE"
+	int a_sortColumn;                        ///< Spalte, nach der sortiert wird (-1: keine)
+	Qt::SortOrder a_sortOrder;               ///< Sortierreihenfolge
+	QVector<QVariantList> a_rows;            ///< Bisher geladene Zeilen
+	QVariant a_lastSort;                     ///< Wert der Sortierspalte in der letzten geladenen Zeile
+	QVariantList a_lastKeys;                 ///< Schlüssel der letzten geladenen Zeile
+	QHash<int, QVariant> a_headers;          ///< Zuordnung Spalte->Überschrift
+	bool a_atEnd;                            ///< Wurden alle Zeilen geladen?
+	int a_estimate;                          ///< Geschätzte Anzahl der Zeilen (-1: unbekannt)
+	int a_ticket;                            ///< Nummer des ausstehenden Auftrags
+	bool a_first;                            ///< Ist der ausstehende Auftrag die erste Seite?
+
+	QueryRequest m_page() const;
+	QueryRequest m_estimate() const;
+
+public:
+	PagedModel(QObject *parent = 0);
+	QVariant data(const QModelIndex &index, int role) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+	bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role = Qt::EditRole);
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	bool canFetchMore(const QModelIndex &parent) const;
+	void fetchMore(const QModelIndex &parent);
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+	void setStatement(QStringList columns, QString from, QStringList keys, QString table);
+	void setFilter(QString filter);
+	QString filter() const {return a_filter;}
+	int estimatedRowCount() const {return a_estimate;}
+	void select();
+
+private slots:
+	void loadResult(QueryResult result);
+
+signals:
+	void loaded();
+	void estimated(int rows);
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "personindex.h"
+#include "main.h"
+#include <QRegExp>
+#include <QStringList>
+#include <algorithm>
+#include <iterator>
+
+PersonIndex *PersonIndex::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von PersonIndex
+ * \param parent Elternobjekt
+ *
+ * Das Verzeichnis ist zunächst leer; geladen wird es erst mit reload().
+ */
+PersonIndex::PersonIndex(QObject *parent) : QObject(parent), a_loaded(false), a_ticket(0) {
+	s_instance = this;
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(loadResult(QueryResult)));
+}
+
+/*!
+ * \brief Destruktor von PersonIndex
+ */
+PersonIndex::~PersonIndex() {
+	if (s_instance == this)
+		s_instance = 0;
+}
+
+/*!
+ * \brief Gibt die Instanz der Anwendung zurück
+ * \return Der in main() erzeugte PersonIndex
+ */
+PersonIndex *PersonIndex::instance() {
+	Q_ASSERT(s_instance);
+	return s_instance;
+}
+
+/*!
+ * \brief Lädt `lehrer` und `schueler` im Hintergrund neu
+ *
+ * Die Klasse wird nicht über den View `SSchueler` abgefragt, sondern mit formName() berechnet.
+ * Bis das Ergebnis da ist, bleibt der bisherige Stand gültig.
+ */
+void PersonIndex::reload() {
+	a_ticket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "reload"), QList<QueryRequest>()
+		<< QueryRequest("SELECT `id`, `name`, `kuerzel` FROM `lehrer`")
+		<< QueryRequest("SELECT `id`, `name`, `vajahr`, `kbuchst` FROM `schueler`"));
+}
+
+/*!
+ * \brief Übernimmt das Ergebnis von reload()
+ * \param result Ergebnis eines beliebigen Auftrags
+ */
+void PersonIndex::loadResult(QueryResult result) {
+	if (result.ticket != a_ticket)
+		return;
+	a_ticket = 0;
+	if (!result.ok()) {
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+
+	m_build(&a_lists[0], result.sets[0], false);
+	m_build(&a_lists[1], result.sets[1], true);
+	a_loaded = true;
+	emit reloaded();
+}
+
+/*!
+ * \brief Baut den Suchindex einer Liste auf
+ * \param list Liste, die neu aufgebaut wird
+ * \param rows Geladene Zeilen aus `lehrer` bzw. `schueler`
+ * \param isStudent Gibt an, ob es sich um Schüler handelt
+ */
+void PersonIndex::m_build(List *list, const QueryResultSet &rows, bool isStudent) {
+	QRegExp separator("\\W+");
+	*list = List();
+	list->people.reserve(rows.rows.size());
+	list->keys.reserve(rows.rows.size());
+	list->texts.reserve(rows.rows.size());
+
+	foreach (const QVariantList &row, rows.rows) {
+		Person p;
+		p.id = row[0].toInt();
+		p.name = row[1].toString();
+		p.extra = isStudent ? formName(row[2], row[3]) : row[2].toString();
+		int index = list->people.size();
+		QStringList words = fold(QString("%1 %2").arg(p.name).arg(p.extra))
+				.split(separator, QString::SkipEmptyParts);
+		QString text = words.join(' ');
+
+		foreach (const QString &word, words)
+			list->prefixes.append(qMakePair(word, index));
+		for (int i = 0; i + 3 <= text.size(); ++i) {
+			QVector<int> &postings = list->trigrams[text.mid(i, 3)];
+			if (postings.isEmpty() || postings.last() != index)
+				postings.append(index);
+		}
+		list->people.append(p);
+		list->keys.append(fold(p.name));
+		list->texts.append(text);
+		list->sorted.append(index);
+	}
+
+	std::sort(list->prefixes.begin(), list->prefixes.end());
+	const QVector<QString> &keys = list->keys;
+	std::sort(list->sorted.begin(), list->sorted.end(), [&keys](int a, int b) {
+		return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+	});
+}
+
+/*!
+ * \brief Sucht die Personen heraus, die für eine Eingabe überhaupt in Frage kommen
+ * \param list Liste
+ * \param words Wörter der Eingabe nach fold()
+ * \return Personen, aufsteigend
+ *
+ * Gesucht wird nur nach dem längsten Wort: Ab drei Zeichen über die Schnittmenge seiner Trigramme,
+ * sonst über die Wortanfänge. Ob wirklich alle Wörter passen, prüft erst m_match().
+ */
+QVector<int> PersonIndex::m_candidates(const List &list, const QStringList &words) {
+	QString longest;
+	foreach (const QString &word, words)
+		if (word.size() > longest.size())
+			longest = word;
+
+	QVector<int> result;
+	if (longest.size() < 3) {
+		QVector<QPair<QString, int> >::const_iterator i = std::lower_bound(list.prefixes.begin(),
+			list.prefixes.end(), qMakePair(longest, -1));
+		for (; i != list.prefixes.end() && i->first.startsWith(longest); ++i)
+			result.append(i->second);
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	QList<const QVector<int> *> postings;
+	for (int i = 0; i + 3 <= longest.size(); ++i) {
+		QHash<QString, QVector<int> >::const_iterator p = list.trigrams.constFind(longest.mid(i, 3));
+		if (p == list.trigrams.constEnd())
+			return result;
+		postings.append(&p.value());
+	}
+	std::sort(postings.begin(), postings.end(), [](const QVector<int> *a, const QVector<int> *b) {
+		return a->size() < b->size();
+	});
+	result = *postings.first();
+	for (int i = 1; i < postings.size() && !result.isEmpty(); ++i) {
+		QVector<int> next;
+		std::set_intersection(result.begin(), result.end(), postings[i]->begin(), postings[i]->end(),
+				      std::back_inserter(next));
+		result = next;
+	}
+	return result;
+}
+
+/*!
+ * \brief Prüft, wie gut ein Wort der Eingabe passt
+ * \param text Wörter einer Person (siehe List::texts)
+ * \param word Wort der Eingabe
+ * \return 2 - Anfang eines Wortes, 1 - Teil eines Wortes (ab drei Zeichen), 0 - passt nicht
+ */
+int PersonIndex::m_match(const QString &text, const QString &word) {
+	int i = text.indexOf(word);
+	while (i > 0 && text[i - 1] != ' ')
+		i = text.indexOf(word, i + 1);
+	if (i >= 0)
+		return 2;
+	return word.size() >= 3 && text.contains(word) ? 1 : 0;
+}
+
+/*!
+ * \brief Bewertet einen Treffer
+ * \param list Liste
+ * \param person Person
+ * \param query Eingabe nach fold()
+ * \param words Wörter der Eingabe
+ * \return -1 - kein Treffer, sonst 0 - Name stimmt überein, 1 - Name beginnt mit der Eingabe,
+ *         2 - alle Wörter sind Wortanfänge, 3 - sonst
+ */
+int PersonIndex::m_rank(const List &list, int person, const QString &query, const QStringList &words) {
+	const QString &text = list.texts[person];
+	bool prefixes = true;
+	foreach (const QString &word, words) {
+		int m = m_match(text, word);
+		if (m == 0)
+			return -1;
+		prefixes = prefixes && m == 2;
+	}
+	const QString &key = list.keys[person];
+	if (key == query)
+		return 0;
+	if (key.startsWith(query))
+		return 1;
+	return prefixes ? 2 : 3;
+}
+
+/*!
+ * \brief Sucht Schüler oder Lehrer
+ * \param isStudent Gibt an, ob Schüler gesucht werden
+ * \param text Eingabe; jedes Wort muss in Name, Klasse bzw. Kürzel vorkommen
+ * \return Treffer, die besten zuerst und bei gleicher Güte nach Namen; ohne Eingabe alle Personen nach Namen
+ */
+QList<PersonIndex::Person> PersonIndex::search(bool isStudent, QString text) const {
+	const List &list = a_lists[isStudent ? 1 : 0];
+	QString query = fold(text).simplified();
+	QStringList words = query.split(QRegExp("\\W+"), QString::SkipEmptyParts);
+	QList<Person> result;
+
+	if (words.isEmpty()) {
+		result.reserve(list.sorted.size());
+		foreach (int i, list.sorted)
+			result.append(list.people[i]);
+		return result;
+	}
+
+	QVector<QPair<int, int> > ranked;
+	foreach (int i, m_candidates(list, words)) {
+		int rank = m_rank(list, i, query, words);
+		if (rank >= 0)
+			ranked.append(qMakePair(rank, i));
+	}
+	const QVector<QString> &keys = list.keys;
+	std::sort(ranked.begin(), ranked.end(), [&keys](const QPair<int, int> &a, const QPair<int, int> &b) {
+		if (a.first != b.first)
+			return a.first < b.first;
+		return keys[a.second] < keys[b.second] || (keys[a.second] == keys[b.second] && a.second < b.second);
+	});
+
+	result.reserve(ranked.size());
+	for (int i = 0; i < ranked.size(); ++i)
+		result.append(list.people[ranked[i].second]);
+	return result;
+}
@@ -0,0 +1,69 @@
+#ifndef PERSONINDEX_H
+#define PERSONINDEX_H
+
+#include "executor.h"
+#include <QObject>
+#include <QHash>
+#include <QVector>
+
+/*!
+ * \brief Im Speicher gehaltenes Namensverzeichnis aller Schüler und Lehrer
+ *
+ * `schueler` und `lehrer` werden einmal (im Hintergrund) geladen. search() sucht danach ohne
+ * Datenbankzugriff über zwei Indizes: sortierte Wortanfänge für kurze Eingaben und Trigramme
+ * (alle Folgen aus drei Zeichen) für Teilwörter. Verglichen wird nach fold().
+ */
+class PersonIndex : public QObject {
+	Q_OBJECT
+public:
+	/*!
+	 * \brief Ein Schüler oder Lehrer
+	 */
+	struct Person {
+		int id;                          ///< Laufende Nummer
+		QString name;                    ///< Name
+		QString extra;                   ///< Klasse des Schülers bzw. Kürzel des Lehrers
+	};
+
+private:
+	/*!
+	 * \brief Suchindex über die Schüler oder die Lehrer
+	 */
+	struct List {
+		QVector<Person> people;          ///< Alle Personen
+		QVector<QString> keys;           ///< Zuordnung Person->Name nach fold()
+		QVector<QString> texts;          ///< Zuordnung Person->Wörter aus Name und extra nach fold(), mit ' ' verbunden
+		QVector<int> sorted;             ///< Alle Personen nach Namen sortiert
+		QVector<QPair<QString, int> > prefixes; ///< Alle Wörter mit ihrer Person, sortiert
+		QHash<QString, QVector<int> > trigrams; ///< Zuordnung Trigramm->Personen (aufsteigend)
+	};
+
+	static PersonIndex *s_instance;          ///< Die Instanz der Anwendung
+	List a_lists[2];                         ///< Lehrer (0) und Schüler (1)
+	bool a_loaded;                           ///< Wurde das Verzeichnis schon einmal geladen?
+	int a_ticket;                            ///< Nummer des ausstehenden Ladeauftrags
+
+	static void m_build(List *list, const QueryResultSet &rows, bool isStudent);
+	static QVector<int> m_candidates(const List &list, const QStringList &words);
+	static int m_match(const QString &text, const QString &word);
+	static int m_rank(const List &list, int person, const QString &query, const QStringList &words);
+
+public:
+	PersonIndex(QObject *parent = 0);
+	~PersonIndex();
+	static PersonIndex *instance();
+
+	bool isLoaded() const {return a_loaded;}
+	QList<Person> search(bool isStudent, QString text) const;
+
+public slots:
+	void reload();
+
+private slots:
+	void loadResult(QueryResult result);
+
+signals:
+	void reloaded();
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "querystats.h"
+#include "tracer.h"
+#include "watchdog.h"
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QStringList>
+#include <QDateTime>
+#include <QThread>
+#include <QTextStream>
+#include <QVariant>
+#include <algorithm>
+
+QueryStats *QueryStats::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von Shape
+ */
+QueryStats::Shape::Shape() : count(0), failed(0), rows(0), total(0), max(0) {
+	for (int i = 0; i < 4; ++i)
+		phases[i] = 0;
+	for (int i = 0; i < a_buckets; ++i)
+		histogram[i] = 0;
+}
+
+/*!
+ * \brief Konstruktor von QueryStats
+ * \param logFile Pfad des Slow-Query-Logs ("" - kein Log)
+ * \param thresholdMs Statements ab dieser Gesamtdauer in Millisekunden werden protokolliert
+ *
+ * Das Log wird nur angehängt, nie überschrieben.
+ */
+QueryStats::QueryStats(QString logFile, int thresholdMs) : a_threshold(qint64(thresholdMs) * 1000000) {
+	s_instance = this;
+	if (!logFile.isEmpty()) {
+		a_log.setFileName(logFile);
+		if (!a_log.open(QIODevice::Append | QIODevice::Text))
+			qWarning("Slow-Query-Log %s kann nicht geöffnet werden", qPrintable(logFile));
+	}
+}
+
+/*!
+ * \brief Destruktor von QueryStats
+ *
+ * Schreibt die Zusammenfassung aller Statement-Formen ins Log.
+ */
+QueryStats::~QueryStats() {
+	if (a_log.isOpen() && !a_shapes.isEmpty()) {
+		QTextStream out(&a_log);
+		out.setCodec("UTF-8");
+		out << QDateTime::currentDateTime().toString(Qt::ISODate) << " Zusammenfassung\n" << report() << "\n";
+	}
+	if (s_instance == this)
+		s_instance = 0;
+}
+
+/*!
+ * \brief Bestimmt die Form eines Statements
+ * \param sql Statement
+ * \return Statement ohne Literale und mit zusammengezogenen Wiederholungen
+ *
+ * Aus "WHERE `id` IN (:bid0, :bid1, :bid2) AND `name` = 'x'" wird "WHERE `id` IN (:bid?, ...) AND `name` = ?".
+ */
+QString QueryStats::shape(QString sql) {
+	static const QRegExp strings("'(?:[^'\\\\]|\\\\.|'')*'");
+	static const QRegExp numbers("\\b\\d+(?:\\.\\d+)?\\b");
+	static const QRegExp numbered("(:[A-Za-z_]+)\\d+\\b");
+	static const QRegExp cases("( WHEN \\S+ THEN \\S+)(?:\\1)+");
+	static const QRegExp lists("(\\?|:[A-Za-z_]+\\?|\\([^()]*\\))(?:, \\1)+");
+
+	QString s = sql.simplified();
+	s.replace(QRegExp(strings), "?");
+	s.replace(QRegExp(numbers), "?");
+	s.replace(QRegExp(numbered), "\\1?");
+	s.replace(QRegExp(cases), "\\1 ...");
+	// zweimal, damit auch die Zeilen eines mehrzeiligen INSERT zusammengezogen werden
+	s.replace(QRegExp(lists), "\\1, ...");
+	s.replace(QRegExp(lists), "\\1, ...");
+	return s;
+}
+
+/*!
+ * \brief Gibt die Histogrammklasse einer Dauer an
+ * \param ns Dauer in Nanosekunden
+ * \return 0 für < 1 ms, 1 für < 2 ms, ..., a_buckets - 1 für alles darüber
+ */
+int QueryStats::bucket(qint64 ns) {
+	qint64 limit = 1000000;
+	int i = 0;
+	while (i < a_buckets - 1 && ns >= limit) {
+		limit *= 2;
+		++i;
+	}
+	return i;
+}
+
+/*!
+ * \brief Trägt eine Messung ein
+ * \param t Messung
+ *
+ * Ohne Instanz (z.B. in Werkzeugen ohne main()) wird die Messung nur an den Tracer weitergegeben.
+ */
+void QueryStats::add(const QueryTiming &t) {
+	QueryStats *stats = s_instance;
+	if (t.sql.isEmpty() || (!stats && t.start < 0))
+		return;
+	QString form = shape(t.sql);
+	qint64 total = t.total();
+	if (t.start >= 0) {
+		QVariantMap args;
+		args["sql"] = form;
+		args["rows"] = t.rows;
+		args["ok"] = t.ok;
+		args["prepare_ms"] = t.prepare / 1e6;
+		args["exec_ms"] = t.exec / 1e6;
+		args["all_ms"] = t.all / 1e6;
+		Tracer::complete("sql", form.left(80), t.start, t.end, args);
+	}
+	if (!stats)
+		return;
+
+	QMutexLocker locker(&stats->a_mutex);
+	Shape &s = stats->a_shapes[form];
+	++s.count;
+	if (!t.ok)
+		++s.failed;
+	s.rows += t.rows;
+	s.total += total;
+	s.max = qMax(s.max, total);
+	s.phases[0] += t.prepare;
+	s.phases[1] += t.exec;
+	s.phases[2] += qMax(t.first, qint64(0));
+	s.phases[3] += t.all;
+	++s.histogram[bucket(total)];
+	if (total >= stats->a_threshold)
+		stats->m_log(t, form);
+}
+
+/*!
+ * \brief Schreibt ein langsames Statement ins Log
+ * \param t Messung
+ * \param shape Form des Statements; die Werte selbst erscheinen nicht im Log, nur ihre Typen
+ *
+ * Muss mit gesperrtem a_mutex aufgerufen werden.
+ */
+void QueryStats::m_log(const QueryTiming &t, const QString &shape) {
+	if (!a_log.isOpen())
+		return;
+	QTextStream out(&a_log);
+	out.setCodec("UTF-8");
+	out << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz")
+	    << QString(" %1 ms (prepare %2, exec %3, erste Zeile %4, alle Zeilen %5) %6 Zeilen, Thread %7%8\n")
+	       .arg(t.total() / 1e6, 0, 'f', 1).arg(t.prepare / 1e6, 0, 'f', 1).arg(t.exec / 1e6, 0, 'f', 1)
+	       .arg(t.first < 0 ? QString("-") : QString::number(t.first / 1e6, 'f', 1))
+	       .arg(t.all / 1e6, 0, 'f', 1).arg(t.rows).arg(quintptr(QThread::currentThreadId()), 0, 16)
+	       .arg(t.ok ? "" : ", fehlgeschlagen")
+	    << "  " << shape << "\n";
+	if (!t.values.isEmpty())
+		out << "  Werte: " << t.values.join(", ") << "\n";
+	out.flush();
+}
+
+/*!
+ * \brief Gibt eine Kopie der Statistik zurück
+ */
+QHash<QString, QueryStats::Shape> QueryStats::shapes() const {
+	QMutexLocker locker(&a_mutex);
+	return a_shapes;
+}
+
+/*!
+ * \brief Erzeugt eine lesbare Zusammenfassung
+ * \return Eine Zeile pro Statement-Form, nach Gesamtzeit absteigend, mit Histogramm
+ */
+QString QueryStats::report() const {
+	QHash<QString, Shape> all = shapes();
+	QList<QPair<qint64, QString> > order;
+	for (QHash<QString, Shape>::const_iterator i = all.constBegin(); i != all.constEnd(); ++i)
+		order.append(qMakePair(-i->total, i.key()));
+	std::sort(order.begin(), order.end());
+
+	QString result;
+	QTextStream out(&result);
+	for (int i = 0; i < order.size(); ++i) {
+		const Shape &s = all[order[i].second];
+		QStringList histogram;
+		for (int b = 0; b < a_buckets; ++b)
+			if (s.histogram[b] > 0)
+				histogram << QString("%1%2 ms: %3").arg(b == a_buckets - 1 ? ">=" : "<")
+					     .arg(1 << (b == a_buckets - 1 ? b - 1 : b)).arg(s.histogram[b]);
+		out << QString("%1 x, %2 ms gesamt, Ø %3 ms, max. %4 ms, Ø %5 Zeilen, Ø Phasen %6/%7/%8/%9 ms%10\n")
+		       .arg(s.count).arg(s.total / 1e6, 0, 'f', 1).arg(s.total / 1e6 / s.count, 0, 'f', 2)
+		       .arg(s.max / 1e6, 0, 'f', 1).arg(double(s.rows) / s.count, 0, 'f', 1)
+		       .arg(s.phases[0] / 1e6 / s.count, 0, 'f', 2).arg(s.phases[1] / 1e6 / s.count, 0, 'f', 2)
+		       .arg(s.phases[2] / 1e6 / s.count, 0, 'f', 2).arg(s.phases[3] / 1e6 / s.count, 0, 'f', 2)
+		       .arg(s.failed ? QString(", %1 fehlgeschlagen").arg(s.failed) : QString())
+		    << "  " << order[i].second << "\n"
+		    << "  " << histogram.join(", ") << "\n";
+	}
+	return result;
+}
+
+/*!
+ * \brief Zuweisung; ein laufendes Statement wird vorher abgeschlossen
+ */
+TimedQuery &TimedQuery::operator=(const TimedQuery &other) {
+	m_finish();
+	QSqlQuery::operator=(other);
+	a_timing = QueryTiming();
+	return *this;
+}
+
+/*!
+ * \brief Beginnt die Messung eines neuen Statements
+ * \param sql Statement; "" - das zuletzt vorbereitete Statement wird erneut ausgeführt
+ */
+void TimedQuery::m_start(QString sql) {
+	m_finish();
+	if (!sql.isEmpty()) {
+		a_timing = QueryTiming();
+		a_timing.sql = sql;
+	}
+	a_timing.values.clear();
+	QMapIterator<QString, QVariant> i(boundValues());
+	while (i.hasNext())
+		a_timing.values << i.next().value().typeName();
+	if (a_timing.start < 0)
+		a_timing.start = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, a_timing.sql.isEmpty() ? lastQuery() : a_timing.sql);
+	a_timer.start();
+}
+
+/*!
+ * \brief Hält das Ende von exec() fest
+ * \param ok Ergebnis von exec()
+ * \return ok
+ *
+ * Statements ohne Ergebnismenge sind damit bereits abgeschlossen.
+ */
+bool TimedQuery::m_executed(bool ok) {
+	a_timing.exec = a_timer.nsecsElapsed();
+	a_timing.all = a_timing.exec;
+	a_timing.end = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, QString());
+	a_timing.ok = ok;
+	a_active = true;
+	if (!ok || !isSelect()) {
+		a_timing.rows = ok ? numRowsAffected() : 0;
+		m_finish();
+	}
+	return ok;
+}
+
+/*!
+ * \brief Schließt die Messung ab und übergibt sie an QueryStats
+ *
+ * Das Statement bleibt für ein erneutes exec() erhalten, die Dauer von prepare() zählt aber nur einmal.
+ */
+void TimedQuery::m_finish() {
+	if (!a_active)
+		return;
+	a_active = false;
+	QueryStats::add(a_timing);
+	QString sql = a_timing.sql;
+	a_timing = QueryTiming();
+	a_timing.sql = sql;
+}
+
+/*!
+ * \brief Bereitet ein Statement vor und misst die Dauer
+ */
+bool TimedQuery::prepare(const QString &query) {
+	m_finish();
+	a_timing = QueryTiming();
+	a_timing.sql = query;
+	a_timing.start = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, query);
+	QElapsedTimer timer;
+	timer.start();
+	bool ok = QSqlQuery::prepare(query);
+	a_timing.prepare = timer.nsecsElapsed();
+	Watchdog::enter(Watchdog::Statement, QString());
+	return ok;
+}
+
+/*!
+ * \brief Führt ein Statement direkt aus und misst die Dauer
+ */
+bool TimedQuery::exec(const QString &query) {
+	m_start(query);
+	return m_executed(QSqlQuery::exec(query));
+}
+
+/*!
+ * \brief Führt das vorbereitete Statement aus und misst die Dauer
+ */
+bool TimedQuery::exec() {
+	m_start(QString());
+	if (a_timing.sql.isEmpty())
+		a_timing.sql = lastQuery();
+	return m_executed(QSqlQuery::exec());
+}
+
+/*!
+ * \brief Liest die nächste Zeile; gemessen wird nur die Zeit in QSqlQuery::next(), nicht die des Aufrufers
+ */
+bool TimedQuery::next() {
+	if (!a_active)
+		return QSqlQuery::next();
+	QElapsedTimer timer;
+	timer.start();
+	Watchdog::enter(Watchdog::Statement, a_timing.sql);
+	bool ok = QSqlQuery::next();
+	a_timing.all += timer.nsecsElapsed();
+	a_timing.end = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, QString());
+	if (!ok) {
+		m_finish();
+	} else if (a_timing.rows++ == 0) {
+		a_timing.first = a_timing.all;
+	}
+	return ok;
+}
+
+/*!
+ * \brief Springt zur ersten Zeile
+ * \see next()
+ */
+bool TimedQuery::first() {
+	if (!a_active)
+		return QSqlQuery::first();
+	QElapsedTimer timer;
+	timer.start();
+	Watchdog::enter(Watchdog::Statement, a_timing.sql);
+	bool ok = QSqlQuery::first();
+	a_timing.all += timer.nsecsElapsed();
+	a_timing.end = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, QString());
+	if (ok && a_timing.rows == 0) {
+		a_timing.rows = 1;
+		a_timing.first = a_timing.all;
+	}
+	return ok;
+}
+
+/*!
+ * \brief Schließt die Messung ab und gibt die Ergebnismenge frei
+ */
+void TimedQuery::finish() {
+	m_finish();
+	QSqlQuery::finish();
+}
@@ -0,0 +1,112 @@
+#ifndef QUERYSTATS_H
+#define QUERYSTATS_H
+
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <QStringList>
+#include <QFile>
+
+/*!
+ * \brief Gemessene Zeiten eines einzelnen Statements (alle Zeiten in Nanosekunden)
+ */
+struct QueryTiming {
+	QString sql;                             ///< Statement, wie es übergeben wurde
+	QStringList values;                      ///< Typen der gebundenen Werte (die Werte selbst werden nie gespeichert)
+	qint64 prepare;                          ///< Dauer von prepare() (0 ohne Prepared Statement)
+	qint64 exec;                             ///< Dauer von exec()
+	qint64 first;                            ///< Zeit bis zur ersten Zeile ab Beginn von exec() (-1: keine Zeile)
+	qint64 all;                              ///< Zeit bis zur letzten gelesenen Zeile ab Beginn von exec()
+	int rows;                                ///< Gelesene bzw. veränderte Zeilen
+	bool ok;                                 ///< War das Statement erfolgreich?
+	qint64 start;                            ///< Beginn nach Tracer::now() (-1: Tracing ausgeschaltet)
+	qint64 end;                              ///< Ende der letzten Phase nach Tracer::now()
+
+	QueryTiming() : prepare(0), exec(0), first(-1), all(0), rows(0), ok(true), start(-1), end(-1) {}
+	qint64 total() const {return prepare + qMax(exec, all);}
+};
+
+/*!
+ * \brief Sammelt die Laufzeiten aller Statements
+ *
+ * Statements werden nach ihrer Form (shape()) zusammengefasst: Literale und durchnummerierte Platzhalter
+ * werden ersetzt, Wiederholungen wie bei IN (...) oder mehrzeiligem INSERT zusammengezogen. Pro Form wird ein
+ * Histogramm der Gesamtdauer geführt. Statements über der Schwelle landen mit geschwärzten Werten im
+ * Slow-Query-Log. Läuft ein Tracer, wird jedes Statement zusätzlich mit seiner Form als Ereignis gemeldet.
+ * Wird aus mehreren Threads benutzt.
+ */
+class QueryStats {
+public:
+	static constexpr int a_buckets = 16;     ///< Histogrammklassen: < 1 ms, < 2 ms, < 4 ms, ..., ab 16 s
+
+	/*!
+	 * \brief Statistik einer Statement-Form
+	 */
+	struct Shape {
+		int count;                       ///< Anzahl der Ausführungen
+		int failed;                      ///< Davon fehlgeschlagen
+		qint64 rows;                     ///< Summe der Zeilen
+		qint64 total;                    ///< Summe der Gesamtdauer
+		qint64 max;                      ///< Längste Gesamtdauer
+		qint64 phases[4];                ///< Summen von prepare, exec, erster und aller Zeilen
+		int histogram[a_buckets];        ///< Anzahl pro Histogrammklasse
+
+		Shape();
+	};
+
+private:
+	static QueryStats *s_instance;           ///< Die Instanz der Anwendung
+	mutable QMutex a_mutex;                  ///< Schützt alle folgenden Attribute
+	QHash<QString, Shape> a_shapes;          ///< Zuordnung Form->Statistik
+	QFile a_log;                             ///< Slow-Query-Log
+	qint64 a_threshold;                      ///< Schwelle für das Slow-Query-Log
+
+	void m_log(const QueryTiming &t, const QString &shape);
+
+public:
+	QueryStats(QString logFile, int thresholdMs);
+	~QueryStats();
+	static QueryStats *instance() {return s_instance;}
+	static void add(const QueryTiming &t);
+	static QString shape(QString sql);
+	static int bucket(qint64 ns);
+
+	QHash<QString, Shape> shapes() const;
+	QString report() const;
+};
+
+/*!
+ * \brief QSqlQuery, das seine Statements für QueryStats misst
+ *
+ * Verdeckt prepare(), exec(), next(), first() und finish(). Gemessen wird, solange das Objekt über seinen eigenen
+ * Typ benutzt wird; die Hilfsfunktionen in main.h nehmen deshalb ein TimedQuery. Ein Statement gilt als
+ * abgeschlossen, sobald keine Zeile mehr kommt, ein neues Statement beginnt oder das Objekt zerstört wird.
+ * Während exec(), next() und first() ist das Statement beim Watchdog als aktiver Bereich gemeldet.
+ */
+class TimedQuery : public QSqlQuery {
+private:
+	QueryTiming a_timing;                    ///< Messung des laufenden Statements
+	QElapsedTimer a_timer;                   ///< Läuft ab Beginn von exec()
+	bool a_active;                           ///< Wird gerade ein Statement gemessen?
+
+	void m_start(QString sql);
+	bool m_executed(bool ok);
+	void m_finish();
+
+public:
+	TimedQuery() : QSqlQuery(), a_active(false) {}
+	TimedQuery(QSqlDatabase db) : QSqlQuery(db), a_active(false) {}
+	TimedQuery(const TimedQuery &other) : QSqlQuery(other), a_active(false) {}
+	~TimedQuery() {m_finish();}
+	TimedQuery &operator=(const TimedQuery &other);
+
+	bool prepare(const QString &query);
+	bool exec(const QString &query);
+	bool exec();
+	bool next();
+	bool first();
+	void finish();
+};
+
+#endif
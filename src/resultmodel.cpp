@@ -0,0 +1,156 @@
+#include "resultmodel.h"
+#include "main.h"
+
+/*!
+ * \brief Konstruktor von ResultModel
+ * \param parent Elternobjekt
+ *
+ * Verbindet das Modell mit dem QueryExecutor, damit es seine Ergebnisse erhält.
+ */
+ResultModel::ResultModel(QObject *parent) : QAbstractTableModel(parent),
+	a_sortColumn(-1), a_sortOrder(Qt::AscendingOrder), a_ticket(0) {
+	connect(QueryExecutor::instance(), SIGNAL(finished(QueryResult)), this, SLOT(loadResult(QueryResult)));
+}
+
+/*!
+ * \brief Setzt die Abfrage
+ * \param select Spaltenliste, z.B. "SELECT `id`, `name`"
+ * \param from Tabellen inkl. Joins (ohne "FROM")
+ */
+void ResultModel::setStatement(QString select, QString from) {
+	a_select = select;
+	a_from = from;
+}
+
+/*!
+ * \brief Setzt die WHERE-Bedingung
+ * \param filter Bedingung ohne "WHERE" oder ""
+ *
+ * Wie bei QSqlTableModel muss anschließend select() aufgerufen werden.
+ */
+void ResultModel::setFilter(QString filter) {
+	a_filter = filter;
+}
+
+/*!
+ * \brief Setzt die Sortierung und lädt die Daten neu
+ * \param column Spalte, nach der sortiert wird
+ * \param order Reihenfolge
+ */
+void ResultModel::sort(int column, Qt::SortOrder order) {
+	a_sortColumn = column;
+	a_sortOrder = order;
+	select();
+}
+
+/*!
+ * \brief Setzt die vollständige Abfrage zusammen
+ * \return SQL-Abfrage
+ */
+QString ResultModel::statement() const {
+	QString query = QString("%1 FROM %2").arg(a_select).arg(a_from);
+	if (!a_filter.isEmpty())
+		query += QString(" WHERE %1").arg(a_filter);
+	if (a_sortColumn >= 0)
+		query += QString(" ORDER BY %1 %2").arg(a_sortColumn + 1)
+				.arg(a_sortOrder == Qt::AscendingOrder ? "ASC" : "DESC");
+	return query;
+}
+
+/*!
+ * \brief Lädt die Daten im Hintergrund neu
+ *
+ * Ein noch ausstehender Auftrag dieses Modells wird dabei verworfen.
+ */
+void ResultModel::select() {
+	a_ticket = QueryExecutor::instance()->submit(QueryExecutor::channel(this, "select"),
+						      QueryRequest(statement()));
+}
+
+/*!
+ * \brief Übernimmt das Ergebnis des Auftrags
+ * \param result Ergebnis eines beliebigen Auftrags
+ */
+void ResultModel::loadResult(QueryResult result) {
+	if (result.ticket != a_ticket)
+		return;
+	a_ticket = 0;
+	if (!result.ok()) {
+		sqlError(result.error, result.failedQuery);
+		return;
+	}
+	beginResetModel();
+	a_data = result.sets.value(0);
+	endResetModel();
+	emit loaded();
+}
+
+/*!
+ * \brief Gibt einen Datensatz mit Spaltennamen zurück
+ * \param row Zeile
+ * \return Datensatz oder leerer Datensatz, falls row ungültig ist
+ */
+QSqlRecord ResultModel::record(int row) const {
+	if (row < 0 || row >= a_data.rows.size())
+		return QSqlRecord();
+	QSqlRecord r = a_data.columns;
+	const QVariantList &values = a_data.rows[row];
+	for (int i = 0; i < values.size(); ++i)
+		r.setValue(i, values[i]);
+	return r;
+}
+
+/*!
+ * \brief Gibt den Inhalt einer Zelle aus
+ * \param index Zelle
+ * \param role Art der Daten
+ * \return Inhalt der Zelle bei Qt::DisplayRole und Qt::EditRole, sonst QVariant()
+ */
+QVariant ResultModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+		return QVariant();
+	return a_data.rows[index.row()].value(index.column());
+}
+
+/*!
+ * \brief Gibt die Spaltenüberschriften aus
+ * \param section Spalte/Zeile
+ * \param orientation Horizontaler oder vertikaler Header
+ * \param role Art der Daten
+ * \return Gesetzte Überschrift, sonst der Spaltenname aus der Abfrage
+ */
+QVariant ResultModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+		if (a_headers.contains(section))
+			return a_headers[section];
+		if (section < a_data.columns.count())
+			return a_data.columns.fieldName(section);
+	}
+	return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+/*!
+ * \brief Setzt eine Spaltenüberschrift
+ * \return true - Überschrift wurde gesetzt
+ */
+bool ResultModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role) {
+	if (orientation != Qt::Horizontal || (role != Qt::EditRole && role != Qt::DisplayRole))
+		return false;
+	a_headers[section] = value;
+	emit headerDataChanged(orientation, section, section);
+	return true;
+}
+
+/*!
+ * \brief Gibt die Anzahl der geladenen Zeilen an
+ */
+int ResultModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : a_data.rows.size();
+}
+
+/*!
+ * \brief Gibt die Anzahl der Spalten an
+ */
+int ResultModel::columnCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : a_data.columns.count();
+}
@@ -0,0 +1,49 @@
+#ifndef RESULTMODEL_H
+#define RESULTMODEL_H
+
+#include "executor.h"
+#include <QAbstractTableModel>
+#include <QSqlRecord>
+
+/*!
+ * \brief Nur lesbares Datenmodell, dessen Abfrage im Hintergrund vom QueryExecutor ausgeführt wird
+ *
+ * Die Abfrage setzt sich wie bei QSqlTableModel aus Spaltenliste, Tabellen (inkl. Joins), Filter und
+ * Sortierung zusammen. select() kehrt sofort zurück; sobald die Daten da sind, wird loaded() emittiert.
+ */
+class ResultModel : public QAbstractTableModel {
+	Q_OBJECT
+private:
+	QString a_select;                        ///< Spaltenliste der Abfrage
+	QString a_from;                          ///< Tabellen der Abfrage inkl. Joins
+	QString a_filter;                        ///< WHERE-Bedingung ohne "WHERE"
+	int a_sortColumn;                        ///< Spalte, nach der sortiert wird (-1: keine)
+	Qt::SortOrder a_sortOrder;               ///< Sortierreihenfolge
+	QueryResultSet a_data;                   ///< Zuletzt geladene Daten
+	QHash<int, QVariant> a_headers;          ///< Zuordnung Spalte->Überschrift
+	int a_ticket;                            ///< Nummer des ausstehenden Auftrags
+
+public:
+	ResultModel(QObject *parent = 0);
+	QVariant data(const QModelIndex &index, int role) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+	bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role = Qt::EditRole);
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+	void setStatement(QString select, QString from);
+	void setFilter(QString filter);
+	QString filter() const {return a_filter;}
+	QString statement() const;
+	QSqlRecord record(int row) const;
+	void select();
+
+private slots:
+	void loadResult(QueryResult result);
+
+signals:
+	void loaded();
+};
+
+#endif
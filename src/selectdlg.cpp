@@ -5,6 +5,88 @@
 #include <QtWidgets>
 #include <QtGui>
 
+/*!
+ * \brief Gibt den Inhalt einer Zelle aus
+ * \param index Zelle
+ * \param role Art der Daten
+ * \return Inhalt der Zelle bei Qt::DisplayRole, sonst QVariant()
+ */
+QVariant PersonModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid() || role != Qt::DisplayRole)
+		return QVariant();
+	const PersonIndex::Person &p = a_people[index.row()];
+	switch (index.column()) {
+	case 0:
+		return p.id;
+	case 1:
+		return a_isStudent ? p.extra : p.name;
+	case 2:
+		return a_isStudent ? p.name : p.extra;
+	}
+	return QVariant();
+}
+
+/*!
+ * \brief Gibt die Spaltenüberschriften aus
+ */
+QVariant PersonModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+		return QAbstractTableModel::headerData(section, orientation, role);
+	switch (section) {
+	case 0:
+		return QString("id");
+	case 1:
+		return a_isStudent ? tr("Klasse") : tr("Name");
+	case 2:
+		return a_isStudent ? tr("Name") : tr("Kürzel");
+	}
+	return QVariant();
+}
+
+/*!
+ * \brief Gibt die Anzahl der Treffer an
+ */
+int PersonModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : a_people.size();
+}
+
+/*!
+ * \brief Gibt die Anzahl der Spalten an
+ */
+int PersonModel::columnCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : 3;
+}
+
+/*!
+ * \brief Ersetzt die angezeigten Personen
+ * \param people Treffer in der anzuzeigenden Reihenfolge
+ */
+void PersonModel::setPeople(const QList<PersonIndex::Person> &people) {
+	beginResetModel();
+	a_people = people;
+	endResetModel();
+}
+
+/*!
+ * \brief Gibt eine Zeile als Datensatz zurück
+ * \param row Zeile
+ * \return Datensatz mit den Feldern id, Klasse, Name (Schüler) bzw. id, name, kuerzel (Lehrer)
+ */
+QSqlRecord PersonModel::record(int row) const {
+	QSqlRecord r;
+	QStringList names;
+	if (a_isStudent)
+		names << "id" << "Klasse" << "Name";
+	else
+		names << "id" << "name" << "kuerzel";
+	for (int c = 0; c < names.size(); ++c) {
+		QSqlField f(names[c], c == 0 ? QVariant::Int : QVariant::String);
+		f.setValue(data(index(row, c), Qt::DisplayRole));
+		r.append(f);
+	}
+	return r;
+}
+
 /*!
  * \brief Erstellt einen neuen SelectDialog
  * \param isStudent Gibt an, ob der Auszuwählende ein Schüler ist
@@ -12,7 +94,7 @@
  * \see m_createComponents(), m_alignComponents(), m_setInitialValues(), m_connectComponents()
  */
 SelectDialog::SelectDialog(bool isStudent, QWidget *parent) :
-	QDialog(parent), a_isStudent(isStudent) {
+	QDialog(parent), a_trace("dialog", "SelectDialog"), a_isStudent(isStudent) {
 	m_createComponents();
 	m_alignComponents();
 	m_setInitialValues();
@@ -24,23 +106,18 @@ SelectDialog::SelectDialog(bool isStudent, QWidget *parent) :
  */
 void SelectDialog::m_createComponents() {
 	a_tableView = new QTableView;
-	a_search = new QPushButton(tr("Suchen"));
 	a_nameFragment = new QLineEdit("");
 	a_buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
 					   Qt::Vertical);
-	a_tableModel = new QSqlTableModel;
+	a_tableModel = new PersonModel(a_isStudent, this);
 }
 
 /*!
  * \brief Ordnet die Komponenten in Layouts an
  */
 void SelectDialog::m_alignComponents() {
-	QHBoxLayout *a = new QHBoxLayout;
-	a->addWidget(a_nameFragment);
-	a->addWidget(a_search);
-
 	QVBoxLayout *b = new QVBoxLayout;
-	b->addLayout(a);
+	b->addWidget(a_nameFragment);
 	b->addWidget(a_tableView);
 
 	QHBoxLayout *layout = new QHBoxLayout;
@@ -52,28 +129,23 @@ void SelectDialog::m_alignComponents() {
 /*!
  * \brief Initialisiert die Komponenten
  *
- * Je nach Art der Person wird die Abfrage der Tabelle und der Titel des
- * Fensters gesetzt. Danach werden allgemeine Einstellungen an der Tabelle
- * getätigt
+ * Je nach Art der Person wird der Titel des Fensters gesetzt und die Liste aus dem PersonIndex
+ * gefüllt. Danach werden allgemeine Einstellungen an der Tabelle getätigt
  */
 void SelectDialog::m_setInitialValues() {
-	if (a_isStudent) {
-		a_tableModel->setQuery("SELECT * FROM `SSchueler`");
+	if (a_isStudent)
 		setWindowTitle(tr("Schüler auswählen"));
-	} else {
-		a_tableModel->setQuery("SELECT * FROM `lehrer`");
+	else
 		setWindowTitle(tr("Lehrer auswählen"));
-		a_tableModel->setHeaderData(1, Qt::Horizontal, tr("Name"));
-		a_tableModel->setHeaderData(2, Qt::Horizontal, tr("Kürzel"));
-	}
+	a_nameFragment->setPlaceholderText(tr("Name, Klasse oder Kürzel eingeben"));
 
 	a_tableView->setAutoScroll(true);
 	a_tableView->setModel(a_tableModel);
 	a_tableView->setSelectionMode(QAbstractItemView::SingleSelection);
 	a_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
-	a_tableView->resizeColumnsToContents();
-	a_search->setDefault(true);
 	a_tableView->verticalHeader()->hide();
+	searchName();
+	a_tableView->resizeColumnsToContents();
 	setFocusProxy(a_nameFragment);
 }
 
@@ -81,44 +153,54 @@ void SelectDialog::m_setInitialValues() {
  * \brief Verbindet die Komponenten mit den Slots
  */
 void SelectDialog::m_connectComponents() {
-	connect(a_search, SIGNAL(clicked()), this, SLOT(searchName()));
+	connect(a_nameFragment, SIGNAL(textChanged(QString)), this, SLOT(searchName()));
 	connect(a_buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
 	connect(a_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 	connect(a_tableView, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(accept()));
+	connect(PersonIndex::instance(), SIGNAL(reloaded()), this, SLOT(indexReloaded()));
 }
 
 /*!
- * \brief Wird bei Klick auf a_search aufgerufen
+ * \brief Wird bei jeder Änderung von a_nameFragment aufgerufen
  *
- * Die Abfrage von a_tableModel wird so verändert, dass nur noch Schüler/Lehrer, deren Name
- * das Namensfragment enthält, angezeigt werden.
+ * Die Treffer werden ohne Datenbankzugriff im PersonIndex gesucht, die besten zuerst. Der erste Treffer
+ * wird ausgewählt, sodass er mit Enter (Ok) übernommen werden kann.
  */
 void SelectDialog::searchName() {
-	if (a_isStudent) {
-		a_tableModel->setQuery(QString("SELECT * FROM `SSchueler` WHERE `Name` LIKE '\%%1\%';")
-					 .arg(escape(a_nameFragment->text())));
-	} else {
-		a_tableModel->setQuery(QString("SELECT * FROM `lehrer` WHERE `name` LIKE '\%%1\%';")
-					 .arg(escape(a_nameFragment->text())));
-	}
+	a_tableModel->setPeople(PersonIndex::instance()->search(a_isStudent, a_nameFragment->text()));
+	if (a_tableModel->rowCount() > 0)
+		a_tableView->selectRow(0);
+	if (!PersonIndex::instance()->isLoaded())
+		a_nameFragment->setPlaceholderText(tr("Namen werden geladen..."));
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn der PersonIndex (neu) geladen wurde
+ *
+ * Die Suche wird mit der bisherigen Eingabe wiederholt.
+ */
+void SelectDialog::indexReloaded() {
+	a_nameFragment->setPlaceholderText(tr("Name, Klasse oder Kürzel eingeben"));
+	searchName();
+	a_tableView->resizeColumnsToContents();
 }
 
 /*!
  * \brief Gibt den ausgewählten Datensatz zurück
  * \return Ausgewählter Datensatz
  *
- * Der Datensatz kommt aus dem View `SSchueler` und hat daher folgende Werte:
+ * Bei einem Schüler hat der Datensatz wie der View `SSchueler` folgende Werte:
  * <ul>
  *	<li>id : Nummer des Schülers</li>
  *	<li>Klasse : Klasse des Schülers</li>
  *	<li>Name : Name des Schülers</li>
  * </ul>
  *
- * Wenn ein Lehrer auszuwählen war, dann handelt es sich um einen Datensatz des `Lehrer`-Views mit folgenden Werten:
+ * Wenn ein Lehrer auszuwählen war, dann hat der Datensatz die Werte aus `lehrer`:
  * <ul>
  *	<li>id : Laufende Nummer des Lehrers</li>
- *	<li>Kürzel : Kürzel des Lehrers</li>
- *	<li>Name : Name des Lehrers (wer hätte das gedacht?)</li>
+ *	<li>name : Name des Lehrers (wer hätte das gedacht?)</li>
+ *	<li>kuerzel : Kürzel des Lehrers</li>
  * </ul>
  */
 QSqlRecord SelectDialog::getRecord() {
@@ -133,7 +215,7 @@ QSqlRecord SelectDialog::getRecord() {
  * \param parent Elternwidget
  * \see m_createComponents(), m_alignComponents(), m_setInitialValues(), m_connectComponents()
  */
-FindDialog::FindDialog(int tabIndex, QWidget *parent) : QDialog(parent) {
+FindDialog::FindDialog(int tabIndex, QWidget *parent) : QDialog(parent), a_trace("dialog", "FindDialog") {
 	m_createComponents();
 	m_alignComponents();
 	indexChanged(tabIndex);
@@ -318,11 +400,49 @@ void FindDialog::m_connectComponents() {
 	connect(a_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 }
 
+/*!
+ * \brief Erzeugt die Bedingung für die Suche nach einem Namen oder Titel
+ * \param column Spalte mit FULLTEXT-Index (ngram-Parser), z.B. `schueler`.`name`
+ * \param text Eingabe
+ * \param grade Spalte mit der Jahrgangsstufe bei der Suche nach Titeln (`jgst`), sonst ""
+ * \return Bedingung ohne führendes Leerzeichen
+ *
+ * Jedes Wort muss als Teilwort vorkommen. Wörter ab zwei Zeichen (ngram_token_size) werden über den
+ * FULLTEXT-Index gesucht, kürzere mit LIKE. Bei Titeln darf eine Zahl wie im View `Buch` (Name und Jgst.) auch
+ * in der Jahrgangsstufe stehen, sodass z.B. "Fokus 7" das Buch "Fokus" der 7. Jgst. findet.
+ */
+QString FindDialog::m_match(QString column, QString text, QString grade) const {
+	QStringList terms, conditions;
+	foreach (QString word, text.simplified().split(' ', QString::SkipEmptyParts)) {
+		word.remove('"');
+		if (word.isEmpty())
+			continue;
+		QString like = QString("LIKE '%%1%'").arg(escape(word).replace('%', "\\%").replace('_', "\\_"));
+		bool number = false;
+		word.toInt(&number);
+		if (number && !grade.isEmpty())
+			conditions << QString("(%1 %2 OR %3 %2)").arg(grade, like, column);
+		else if (word.size() >= 2)
+			terms << QString("+\"%1\"").arg(word);
+		else
+			conditions << QString("%1 %2").arg(column).arg(like);
+	}
+	if (!terms.isEmpty())
+		conditions.prepend(QString("MATCH(%1) AGAINST ('%2' IN BOOLEAN MODE)").arg(column)
+				   .arg(escape(terms.join(' '))));
+	if (conditions.isEmpty())
+		return "TRUE";
+	return conditions.join(" AND ");
+}
+
 /*!
  * \brief Eruiert aus den gegebenen Eingabefeldern die SQL-Abfrage
  * \return Erzeugte SQL-Abfrage oder ""
  *
- * Je nach aktuell angewähltem Tab werden nach ausgeklügeltem System die SQL-Abfragen erzeugt.
+ * Je nach aktuell angewähltem Tab werden nach ausgeklügeltem System die SQL-Abfragen erzeugt. Namen und
+ * Titel werden über die FULLTEXT-Indizes gesucht (siehe m_match()), Klassen über Abschlussjahr und
+ * Klassenbuchstaben (siehe formFilter()), Jahre als Datumsbereich, damit die Bedingungen einen Index benutzen
+ * können.
  */
 QString FindDialog::getFilter() {
 	QString query = "";
@@ -331,19 +451,22 @@ QString FindDialog::getFilter() {
 	switch (a_tabIndex) {
 	case 0:
 		if (!a_sLendForm->text().isEmpty()) {
-			query += tr(" relTblAl_0.`Klasse` = '%1'").arg(escape(a_sLendForm->text().toLower()).simplified());
+			query += tr(" relTblAl_0.`id` IN (SELECT `id` FROM `schueler` WHERE %1)")
+					.arg(formFilter(a_sLendForm->text().toLower()));
 			added = true;
 		}
 		if (!a_sLendName->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_1.`Name` LIKE '\%%1\%'").arg(escape(a_sLendName->text()).simplified());
+			query += tr(" relTblAl_1.`id` IN (SELECT `id` FROM `schueler` WHERE %1)")
+					.arg(m_match("`name`", a_sLendName->text()));
 			added = true;
 		}
 		if (!a_sLendTitle->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_2.`titel` LIKE '\%%1\%'").arg(escape(a_sLendTitle->text()).simplified());
+			query += tr(" relTblAl_2.`isbn` IN (SELECT `isbn` FROM `buch` WHERE %1)")
+					.arg(m_match("`name`", a_sLendTitle->text(), "`jgst`"));
 			added = true;
 		}
 		if (a_sLendDate->date() != a_default) {
@@ -362,13 +485,14 @@ QString FindDialog::getFilter() {
 		if (!a_tLendName->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_0.`name` LIKE '\%%1\%'").arg(escape(a_tLendName->text()).simplified());
+			query += tr(" %1").arg(m_match("relTblAl_0.`name`", a_tLendName->text()));
 			added = true;
 		}
 		if (!a_tLendTitle->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query  += tr(" relTblAl_1.`titel` LIKE '\%%1\%'").arg(escape(a_tLendTitle->text()).simplified());
+			query += tr(" relTblAl_1.`isbn` IN (SELECT `isbn` FROM `buch` WHERE %1)")
+					.arg(m_match("`name`", a_tLendTitle->text(), "`jgst`"));
 			added = true;
 		}
 		if (a_tLendDate->date() != a_default) {
@@ -381,19 +505,22 @@ QString FindDialog::getFilter() {
 
 	case 2:
 		if (!a_swapForm->text().isEmpty()) {
-			query += tr(" relTblAl_0.`Klasse` = '%1'").arg(escape(a_swapForm->text().toLower()).simplified());
+			query += tr(" relTblAl_0.`id` IN (SELECT `id` FROM `schueler` WHERE %1)")
+					.arg(formFilter(a_swapForm->text().toLower()));
 			added = true;
 		}
 		if (!a_swapName->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_1.`Name` LIKE '\%%1\%'").arg(escape(a_swapName->text()).simplified());
+			query += tr(" relTblAl_1.`id` IN (SELECT `id` FROM `schueler` WHERE %1)")
+					.arg(m_match("`name`", a_swapName->text()));
 			added = true;
 		}
 		if (!a_swapTitle->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_2.`titel` LIKE '\%%1\%'").arg(escape(a_swapTitle->text()).simplified());
+			query += tr(" relTblAl_2.`isbn` IN (SELECT `isbn` FROM `buch` WHERE %1)")
+					.arg(m_match("`name`", a_swapTitle->text(), "`jgst`"));
 			added = true;
 		}
 		if (a_swapDate->date() != a_default) {
@@ -405,7 +532,8 @@ QString FindDialog::getFilter() {
 		if (!a_swapYear->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" YEAR(`datum`) = %1").arg(escape(a_swapYear->text()).simplified());
+			int year = a_swapYear->text().toInt();
+			query += tr(" `datum` >= '%1-01-01' AND `datum` < '%2-01-01'").arg(year).arg(year + 1);
 			added = true;
 		}
 		break;
@@ -418,13 +546,14 @@ QString FindDialog::getFilter() {
 		if (!a_aliasIsbn->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" `isbn` = %1").arg(escape(a_aliasIsbn->text()));
+			query += tr(" `aliasse`.`isbn` = %1").arg(escape(a_aliasIsbn->text()));
 			added = true;
 		}
 		if (!a_aliasTitle->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" relTblAl_2.`titel` LIKE '%%%1%%'").arg(escape(a_aliasTitle->text()));
+			query += tr(" `aliasse`.`isbn` IN (SELECT `isbn` FROM `buch` WHERE %1)")
+					.arg(m_match("`name`", a_aliasTitle->text(), "`jgst`"));
 			added = true;
 		}
 		break;
@@ -437,7 +566,7 @@ QString FindDialog::getFilter() {
 		if (!a_studentName->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" `name` LIKE '\%%1\%'").arg(escape(a_studentName->text()).simplified());
+			query += tr(" %1").arg(m_match("`name`", a_studentName->text()));
 			added = true;
 		}
 		if (!a_studentGradYear->text().isEmpty()) {
@@ -468,7 +597,7 @@ QString FindDialog::getFilter() {
 		if (!a_teacherName->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" `name` LIKE '\%%1\%'").arg(escape(a_teacherName->text()).simplified());
+			query += tr(" %1").arg(m_match("`name`", a_teacherName->text()));
 			added = true;
 		}
 		break;
@@ -481,7 +610,7 @@ QString FindDialog::getFilter() {
 		if (!a_bookTitle->text().isEmpty()) {
 			if (added)
 				query += tr(" AND");
-			query += tr(" `name` LIKE '\%%1\%'").arg(escape(a_bookTitle->text()).simplified());
+			query += tr(" %1").arg(m_match("`name`", a_bookTitle->text(), "`jgst`"));
 			added = true;
 		}
 		if (!a_bookForm->text().isEmpty()) {
@@ -11,6 +11,32 @@
 #include <QDateEdit>
 #include <QTableWidget>
 #include <QSqlRecord>
+#include "personindex.h"
+#include "tracer.h"
+
+/*!
+ * \brief Datenmodell der Treffer von SelectDialog
+ *
+ * Zeigt Schüler mit den Spalten des Views `SSchueler` (id, Klasse, Name) bzw. Lehrer mit den Spalten von
+ * `lehrer` (id, name, kuerzel) an.
+ */
+class PersonModel : public QAbstractTableModel {
+	Q_OBJECT
+private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
+	bool a_isStudent;                        ///< Verweist auf die Art der Personen
+	QList<PersonIndex::Person> a_people;     ///< Angezeigte Personen
+
+public:
+	PersonModel(bool isStudent, QObject *parent = 0) : QAbstractTableModel(parent), a_isStudent(isStudent) {}
+	QVariant data(const QModelIndex &index, int role) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+	void setPeople(const QList<PersonIndex::Person> &people);
+	QSqlRecord record(int row) const;
+};
 
 /*!
  * \brief Dialog, mit dem ein Schüler oder Lehrer ausgewählt wird
@@ -24,10 +50,9 @@ public:
 private:
 	bool a_isStudent;                        ///< Verweist auf die Art der Person
 	QTableView *a_tableView;                 ///< Zeigt die Vorschläge an
-	QPushButton *a_search;                   ///< Dient zur Suche nach einem Teil des Namens
 	QLineEdit *a_nameFragment;               ///< Enthält einen Teil des Namens
 	QDialogButtonBox *a_buttonBox;           ///< Ok/Abbrechen
-	QSqlQueryModel *a_tableModel;            ///< Datenmodell für a_tableWidget
+	PersonModel *a_tableModel;               ///< Datenmodell für a_tableView (Treffer aus dem PersonIndex)
 
 	void m_createComponents();
 	void m_alignComponents();
@@ -36,6 +61,7 @@ private:
 
 private slots:
 	void searchName();
+	void indexReloaded();
 
 public slots:
 
@@ -47,6 +73,7 @@ public slots:
 class FindDialog : public QDialog {
 	Q_OBJECT
 private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
 	int a_tabIndex;                          ///< Aktuell ausgewählter Tab
 	QDate a_default;                    ///< Gibt an, ob das Datum von Büchertausch geändert wurde
 
@@ -83,6 +110,7 @@ private:
 	void m_alignComponents();
 	void m_setInitialValues();
 	void m_connectComponents();
+	QString m_match(QString column, QString text, QString grade = QString()) const;
 
 public:
 	FindDialog(int tabIndex, QWidget *parent = 0);
@@ -12,7 +12,7 @@
  * \param parent Eltern-Widget
  * \see m_createComponents(), m_alignComponents, m_setInitialValues(), m_connectComponents()
  */
-SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent) {
+SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent), a_trace("dialog", "SettingsDialog") {
 	m_createComponents();
 	m_alignComponents();
 	m_setInitialValues();
@@ -9,6 +9,7 @@
 #include <QGroupBox>
 #include <QPushButton>
 #include <QSettings>
+#include "tracer.h"
 
 /*!
  * \brief Der Einstellungs-Dialog
@@ -16,6 +17,7 @@
 class SettingsDialog : public QDialog {
 	Q_OBJECT
 private:
+	TraceScope a_trace;                      ///< Meldet die Lebensdauer des Dialogs an den Tracer
 	QDialogButtonBox *a_buttonBox;           ///< Ok/Abbrechen
 	QGroupBox *a_general;                    ///< Enthält allgemeine Einstellungen
 	QGroupBox *a_database;                   ///< Enthält Einstellungen für die Datenbank
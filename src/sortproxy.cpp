@@ -0,0 +1,197 @@
+#include "sortproxy.h"
+#include "main.h"
+#include <QDate>
+#include <QDateTime>
+
+/*!
+ * \brief Konstruktor von SortProxy
+ * \param parent Elternobjekt
+ *
+ * Sortiert wird nur auf Anforderung (sort()), nicht bei jeder Änderung einzelner Zellen.
+ */
+SortProxy::SortProxy(QObject *parent) : QSortFilterProxyModel(parent), a_keyColumn(-1), a_resortPending(false) {
+	setDynamicSortFilter(false);
+}
+
+/*!
+ * \brief Setzt das Quellmodell
+ * \param sourceModel Quellmodell
+ *
+ * Verbindet die Signale des Quellmodells, bei denen die Schlüssel ungültig werden. Nach einem Reset wird
+ * außerdem neu sortiert (siehe sourceReset()).
+ */
+void SortProxy::setSourceModel(QAbstractItemModel *sourceModel) {
+	if (this->sourceModel())
+		disconnect(this->sourceModel(), 0, this, 0);
+	invalidateKeys();
+	QSortFilterProxyModel::setSourceModel(sourceModel);
+	connect(sourceModel, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+	connect(sourceModel, SIGNAL(layoutChanged()), this, SLOT(invalidateKeys()));
+	connect(sourceModel, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(invalidateKeys()));
+	connect(sourceModel, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(invalidateKeys()));
+	connect(sourceModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+		this, SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+}
+
+/*!
+ * \brief Sortiert die Daten
+ * \param column Spalte
+ * \param order Reihenfolge
+ *
+ * Lädt ggf. noch nicht abgeholte Zeilen des Quellmodells nach, damit wirklich alle Zeilen sortiert werden.
+ */
+void SortProxy::sort(int column, Qt::SortOrder order) {
+	while (sourceModel() && sourceModel()->canFetchMore(QModelIndex()))
+		sourceModel()->fetchMore(QModelIndex());
+	a_resortPending = false;
+	QSortFilterProxyModel::sort(column, order);
+}
+
+/*!
+ * \brief Verwirft alle Schlüssel
+ *
+ * Wird aufgerufen, wenn sich die Zeilen des Quellmodells geändert haben.
+ */
+void SortProxy::invalidateKeys() {
+	a_keys.clear();
+	a_keyColumn = -1;
+}
+
+/*!
+ * \brief Wird nach einem Reset des Quellmodells aufgerufen
+ *
+ * Danach sind nur die ersten Zeilen abgeholt und sortiert; später abgeholte Zeilen würden unsortiert angehängt.
+ * Deshalb wird resort() verzögert aufgerufen, damit das Quellmodell sein select() abschließen kann. Sortiert
+ * der Aufrufer bis dahin selbst (sort()), entfällt das zweite Sortieren.
+ */
+void SortProxy::sourceReset() {
+	invalidateKeys();
+	if (a_resortPending)
+		return;
+	a_resortPending = true;
+	QMetaObject::invokeMethod(this, "resort", Qt::QueuedConnection);
+}
+
+/*!
+ * \brief Sortiert erneut nach der zuletzt gewählten Spalte
+ *
+ * Ist seit dem letzten Reset schon sortiert worden oder noch nie, passiert nichts.
+ */
+void SortProxy::resort() {
+	if (!a_resortPending)
+		return;
+	a_resortPending = false;
+	if (sourceModel() && sortColumn() >= 0)
+		sort(sortColumn(), sortOrder());
+}
+
+/*!
+ * \brief Verwirft die Schlüssel geänderter Zeilen
+ * \param topLeft Erste geänderte Zelle
+ * \param bottomRight Letzte geänderte Zelle
+ */
+void SortProxy::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+	for (int row = topLeft.row(); row <= bottomRight.row() && row < a_keys.size(); ++row)
+		a_keys[row].valid = false;
+}
+
+/*!
+ * \brief Gibt den Sortierschlüssel einer Zelle zurück und berechnet ihn bei Bedarf
+ * \param row Zeile im Quellmodell
+ * \param column Spalte im Quellmodell
+ * \return Schlüssel
+ *
+ * a_keys wird beim ersten Aufruf für eine Spalte auf die volle Zeilenzahl gebracht, danach also nicht mehr
+ * umkopiert; zurückgegebene Referenzen bleiben damit während einer Sortierung gültig.
+ */
+const SortProxy::SortKey &SortProxy::m_key(int row, int column) const {
+	if (column != a_keyColumn) {
+		a_keys.clear();
+		a_keyColumn = column;
+	}
+	if (a_keys.size() <= row)
+		a_keys.resize(sourceModel()->rowCount());
+	SortKey &key = a_keys[row];
+	if (key.valid)
+		return key;
+
+	QVariant v = sourceModel()->data(sourceModel()->index(row, column), sortRole());
+	key.valid = true;
+	key.null = v.isNull() || v.toString().isEmpty();
+	key.numeric = false;
+	switch (v.type()) {
+	case QVariant::Int:
+	case QVariant::UInt:
+	case QVariant::LongLong:
+	case QVariant::ULongLong:
+	case QVariant::Double:
+		key.numeric = true;
+		key.number = v.toDouble();
+		break;
+	case QVariant::Date:
+		key.numeric = true;
+		key.number = v.toDate().toJulianDay();
+		break;
+	case QVariant::DateTime:
+		key.numeric = true;
+		key.number = v.toDateTime().toMSecsSinceEpoch();
+		break;
+	default:
+		key.text = fold(v.toString());
+	}
+	return key;
+}
+
+/*!
+ * \brief Vergleicht zwei Zeilen anhand ihrer Schlüssel
+ * \return true - left kommt vor right
+ *
+ * Leere Zellen stehen vorne, wie bei ORDER BY in MySQL. Bei gleichem Schlüssel entscheidet die Zeile im
+ * Quellmodell, damit die Sortierung stabil ist.
+ */
+bool SortProxy::lessThan(const QModelIndex &left, const QModelIndex &right) const {
+	const SortKey &a = m_key(left.row(), left.column());
+	const SortKey &b = m_key(right.row(), right.column());
+	if (a.null != b.null)
+		return a.null;
+	if (!a.null) {
+		if (a.numeric && b.numeric) {
+			if (a.number != b.number)
+				return a.number < b.number;
+		} else {
+			int c = a.text.compare(b.text);
+			if (c != 0)
+				return c < 0;
+		}
+	}
+	return left.row() < right.row();
+}
+
+/*!
+ * \brief Erzeugt den Editor für den Index im Quellmodell
+ */
+QWidget *ProxyRelationalDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option,
+					       const QModelIndex &index) const {
+	const QSortFilterProxyModel *proxy = qobject_cast<const QSortFilterProxyModel *>(index.model());
+	return QSqlRelationalDelegate::createEditor(parent, option, proxy ? proxy->mapToSource(index) : index);
+}
+
+/*!
+ * \brief Füllt den Editor aus dem Quellmodell
+ */
+void ProxyRelationalDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const {
+	const QSortFilterProxyModel *proxy = qobject_cast<const QSortFilterProxyModel *>(index.model());
+	QSqlRelationalDelegate::setEditorData(editor, proxy ? proxy->mapToSource(index) : index);
+}
+
+/*!
+ * \brief Schreibt den Inhalt des Editors in das Quellmodell
+ */
+void ProxyRelationalDelegate::setModelData(QWidget *editor, QAbstractItemModel *model,
+					   const QModelIndex &index) const {
+	QSortFilterProxyModel *proxy = qobject_cast<QSortFilterProxyModel *>(model);
+	if (proxy)
+		QSqlRelationalDelegate::setModelData(editor, proxy->sourceModel(), proxy->mapToSource(index));
+	else
+		QSqlRelationalDelegate::setModelData(editor, model, index);
+}
@@ -0,0 +1,67 @@
+#ifndef SORTPROXY_H
+#define SORTPROXY_H
+
+#include <QSortFilterProxyModel>
+#include <QSqlRelationalDelegate>
+#include <QVector>
+
+/*!
+ * \brief Sortiert vollständig geladene Datenmodelle im Speicher
+ *
+ * Statt bei jedem Vergleich Zellinhalte abzufragen und zu vergleichen, wird pro Zeile einmal ein Sortierschlüssel
+ * berechnet: Zahlen und Datumsangaben als Zahl, Texte ohne Groß-/Kleinschreibung und mit Umlauten wie ihren
+ * Grundbuchstaben (DIN 5007). Die Schlüssel werden verworfen, sobald sich die Daten ändern. Wird das Quellmodell
+ * neu geladen (z.B. nach dem Speichern einer Änderung), wird wieder vollständig sortiert.
+ */
+class SortProxy : public QSortFilterProxyModel {
+	Q_OBJECT
+private:
+	/*!
+	 * \brief Vorberechneter Sortierschlüssel einer Zelle
+	 */
+	struct SortKey {
+		bool valid;                      ///< Wurde der Schlüssel schon berechnet?
+		bool null;                       ///< Ist die Zelle leer?
+		bool numeric;                    ///< Wird nach number statt nach text sortiert?
+		double number;                   ///< Zahlenwert
+		QString text;                    ///< Normalisierter Text
+
+		SortKey() : valid(false), null(true), numeric(false), number(0) {}
+	};
+
+	mutable QVector<SortKey> a_keys;         ///< Zuordnung Quellzeile->Schlüssel der Sortierspalte
+	mutable int a_keyColumn;                 ///< Spalte, zu der a_keys gehört
+	bool a_resortPending;                    ///< Steht nach einem Reset des Quellmodells noch ein resort() aus?
+
+	const SortKey &m_key(int row, int column) const;
+
+protected:
+	bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+
+public:
+	SortProxy(QObject *parent = 0);
+	void setSourceModel(QAbstractItemModel *sourceModel);
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+private slots:
+	void invalidateKeys();
+	void sourceReset();
+	void resort();
+	void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+};
+
+/*!
+ * \brief QSqlRelationalDelegate für ein QSqlRelationalTableModel hinter einem SortProxy
+ *
+ * QSqlRelationalDelegate erkennt die Relation nur am Modell des Index, deshalb werden die Indizes
+ * vorher auf das Quellmodell abgebildet.
+ */
+class ProxyRelationalDelegate : public QSqlRelationalDelegate {
+public:
+	ProxyRelationalDelegate(QObject *parent = 0) : QSqlRelationalDelegate(parent) {}
+	QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+	void setEditorData(QWidget *editor, const QModelIndex &index) const;
+	void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const;
+};
+
+#endif
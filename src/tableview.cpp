@@ -4,6 +4,9 @@
 #include "selectdlg.h"
 #include "settingsdlg.h"
 #include "importdlg.h"
+#include "bookindex.h"
+#include "personindex.h"
+#include "watchdog.h"
 #include <QtCore>
 #include <QtGui>
 #include <QtSql>
@@ -26,7 +29,7 @@ TableView::TableView(QWidget *parent) : QWidget(parent) {
  * \return true - Selektion, false - keine Selektion
  */
 bool TableView::isSelecting() const {
-	return !a_models[tabIndex()]->filter().isEmpty();
+	return !m_filter(tabIndex()).isEmpty();
 }
 
 /*!
@@ -37,6 +40,94 @@ int TableView::tabIndex() const {
 	return a_tabWidget->currentIndex();
 }
 
+/*!
+ * \brief Gibt den Filter eines Tabs an
+ * \param tab Index des Tabs
+ * \return Filter des Datenmodells
+ */
+QString TableView::m_filter(int tab) const {
+	return tab < 3 ? a_lendings[tab]->filter() : a_models[tab]->filter();
+}
+
+/*!
+ * \brief Setzt den Filter eines Tabs
+ * \param tab Index des Tabs
+ * \param filter Neuer Filter
+ */
+void TableView::m_setFilter(int tab, QString filter) {
+	if (tab < 3)
+		a_lendings[tab]->setFilter(filter);
+	else
+		a_models[tab]->setFilter(filter);
+}
+
+/*!
+ * \brief Lädt die Daten eines Tabs neu
+ * \param tab Index des Tabs
+ *
+ * Die Ausleih-Tabs laden im Hintergrund und passen ihre Spalten erst in lendingsLoaded() an. Ein noch nicht
+ * angezeigter Tab wird dabei eingerichtet (siehe m_activate()).
+ */
+void TableView::m_select(int tab) {
+	if (!a_activated[tab]) {
+		m_activate(tab);
+		return;
+	}
+	if (tab < 3)
+		a_lendings[tab]->select();
+	else
+		m_selectModel(tab);
+}
+
+/*!
+ * \brief Lädt einen bearbeitbaren Tab vollständig und sortiert ihn nach seinem Sortierindikator
+ * \param tab Index des Tabs (ab 3)
+ *
+ * QSqlTableModel führt seine Statements selbst aus, deshalb wird hier von außen gemessen und an QueryStats
+ * gemeldet: select() als exec und erste Zeile, das Nachladen aller weiteren Zeilen als letzte Zeile.
+ */
+void TableView::m_selectModel(int tab) {
+	QueryTiming timing;
+	QElapsedTimer timer;
+	timer.start();
+	timing.start = Tracer::now();
+	QString previous = Watchdog::enter(Watchdog::Statement, QString("SELECT * FROM `%1`")
+					   .arg(a_models[tab]->tableName()));
+	timing.ok = a_models[tab]->select();
+	timing.exec = timer.nsecsElapsed();
+	if (a_models[tab]->rowCount() > 0)
+		timing.first = timing.exec;
+	while (a_models[tab]->canFetchMore())
+		a_models[tab]->fetchMore();
+	timing.all = timer.nsecsElapsed();
+	timing.end = Tracer::now();
+	Watchdog::enter(Watchdog::Statement, previous);
+	timing.rows = a_models[tab]->rowCount();
+	timing.sql = a_models[tab]->query().lastQuery();
+	QueryStats::add(timing);
+
+	QHeaderView *header = a_tabs[tab]->horizontalHeader();
+	a_proxies[tab]->sort(header->sortIndicatorSection(), header->sortIndicatorOrder());
+	a_sizer.fit(a_tabs[tab], tab);
+}
+
+/*!
+ * \brief Sortiert einen Tab neu
+ * \param tab Index des Tabs
+ * \param column Spalte
+ * \param order Reihenfolge
+ *
+ * Nur die seitenweise geladenen Ausleih-Tabs werden vom Server sortiert (ORDER BY); column -1 steht dort für
+ * die Reihenfolge des Primärschlüssels. Die übrigen Tabs sind vollständig geladen und werden von ihrem
+ * SortProxy im Speicher sortiert.
+ */
+void TableView::m_sort(int tab, int column, Qt::SortOrder order) {
+	if (tab < 3)
+		a_lendings[tab]->sort(column, order);
+	else
+		a_proxies[tab]->sort(column, order);
+}
+
 /*!
  * \brief Erstellt die Komponenten
  */
@@ -45,9 +136,13 @@ void TableView::m_createComponents() {
 
 	for (int i = 0; i < 7; ++i)
 		a_tabs[i] = new QTableView;
-	a_models[0] = new RORelationalTableModel;
-	a_models[1] = new RORelationalTableModel;
-	a_models[2] = new RORelationalTableModel;
+	for (int i = 0; i < 3; ++i) {
+		a_lendings[i] = new PagedModel(this);
+		a_models[i] = 0;
+		a_proxies[i] = 0;
+	}
+	for (int i = 3; i < 7; ++i)
+		a_proxies[i] = new SortProxy(this);
 	a_models[3] = new QSqlRelationalTableModel;
 	a_models[4] = new QSqlTableModel;
 	a_models[5] = new QSqlTableModel;
@@ -73,85 +168,132 @@ void TableView::m_alignComponents() {
 
 /*!
  * \brief Setzt die Anfangswerte
+ *
+ * Die Datenmodelle werden hier noch nicht eingerichtet (siehe m_activate()). Nur der zuletzt aktive Tab,
+ * der aus den Einstellungen wiederhergestellt wird, lädt sofort seine Daten.
  */
 void TableView::m_setInitialValues() {
-	QSqlRelationalTableModel *m = qobject_cast<QSqlRelationalTableModel *>(a_models[0]);
-	m->setTable("Sausleihe");
-	m->setHeaderData(0, Qt::Horizontal, tr("Klasse"));
-	m->setHeaderData(1, Qt::Horizontal, tr("Schüler"));
-	m->setHeaderData(2, Qt::Horizontal, tr("Buch"));
-	m->setHeaderData(3, Qt::Horizontal, tr("Anzahl"));
-	m->setHeaderData(4, Qt::Horizontal, tr("Datum"));
-	m->setRelation(0, QSqlRelation("SSchueler", "id", "Klasse"));
-	m->setRelation(1, QSqlRelation("SSchueler", "id", "Name"));
-	m->setRelation(2, QSqlRelation("Buch", "isbn", "titel"));
-	m->select();
-
-	m = qobject_cast<QSqlRelationalTableModel *>(a_models[1]);
-	m->setTable("lausleihe");
-	m->setHeaderData(0, Qt::Horizontal, tr("Lehrer"));
-	m->setHeaderData(1, Qt::Horizontal, tr("Buch"));
-	m->setHeaderData(2, Qt::Horizontal, tr("Anzahl"));
-	m->setHeaderData(3, Qt::Horizontal, tr("Datum"));
-	m->setRelation(0, QSqlRelation("lehrer", "id", "name"));
-	m->setRelation(1, QSqlRelation("Buch", "isbn", "titel"));
-	m->select();
-
-	m = qobject_cast<QSqlRelationalTableModel *>(a_models[2]);
-	m->setTable("Btausch");
-	m->setHeaderData(0, Qt::Horizontal, tr("Klasse"));
-	m->setHeaderData(1, Qt::Horizontal, tr("Schüler"));
-	m->setHeaderData(2, Qt::Horizontal, tr("Buch"));
-	m->setHeaderData(3, Qt::Horizontal, tr("Datum"));
-	m->setRelation(0, QSqlRelation("SSchueler", "id", "Klasse"));
-	m->setRelation(1, QSqlRelation("SSchueler", "id", "Name"));
-	m->setRelation(2, QSqlRelation("Buch", "isbn", "titel"));
-	m->select();
-
-	m = qobject_cast<QSqlRelationalTableModel *>(a_models[3]);
-	m->setTable("aliasse");
-	m->setHeaderData(0, Qt::Horizontal, tr("Alias"));
-	m->setHeaderData(1, Qt::Horizontal, tr("Buch"));
-	m->setRelation(1, QSqlRelation("Buch", "isbn", "titel"));
-	m->setEditStrategy(QSqlTableModel::OnFieldChange);
-
-	a_models[4]->setTable("schueler");
-	a_models[4]->setHeaderData(0, Qt::Horizontal, tr("id"));
-	a_models[4]->setHeaderData(1, Qt::Horizontal, tr("Name"));
-	a_models[4]->setHeaderData(2, Qt::Horizontal, tr("Abschlussjahr"));
-	a_models[4]->setHeaderData(3, Qt::Horizontal, tr("Klassenbuchstabe"));
-	a_models[4]->select();
-	a_models[4]->setEditStrategy(QSqlTableModel::OnFieldChange);
-	a_tabs[4]->verticalHeader()->hide();
-
-	a_models[5]->setTable("lehrer");
-	a_models[5]->setHeaderData(0, Qt::Horizontal, tr("id"));
-	a_models[5]->setHeaderData(1, Qt::Horizontal, tr("Name"));
-	a_models[5]->setHeaderData(2, Qt::Horizontal, tr("Kürzel"));
-	a_models[5]->select();
-	a_models[5]->setEditStrategy(QSqlTableModel::OnFieldChange);
-	a_tabs[5]->verticalHeader()->hide();
-
-	a_models[6]->setTable("buch");
-	a_models[6]->setHeaderData(0, Qt::Horizontal, tr("ISBN"));
-	a_models[6]->setHeaderData(1, Qt::Horizontal, tr("Titel"));
-	a_models[6]->setHeaderData(2, Qt::Horizontal, tr("Jgst."));
-	a_models[6]->select();
-	a_models[6]->setEditStrategy(QSqlTableModel::OnFieldChange);
-
 	for (int i = 0; i < 7; ++i) {
-		a_tabs[i]->setModel(a_models[i]);
-		a_tabs[i]->setSortingEnabled(true);
-		a_tabs[i]->sortByColumn(0, Qt::AscendingOrder);
-		a_tabs[i]->horizontalHeader()->setSortIndicator(0, Qt::AscendingOrder);
-		a_tabs[i]->horizontalHeader()->setSortIndicatorShown(true);
+		a_activated[i] = false;
 		a_tabs[i]->setSelectionBehavior(QAbstractItemView::SelectRows);
 		a_tabs[i]->setSelectionMode(QAbstractItemView::SingleSelection);
 	}
+	a_tabs[4]->verticalHeader()->hide();
+	a_tabs[5]->verticalHeader()->hide();
 
 	a_tabWidget->setTabPosition(QTabWidget::South);
-	a_tabs[0]->resizeColumnsToContents();
-	a_tabs[3]->setItemDelegateForColumn(1, new QSqlRelationalDelegate(a_tabs[3]));
+	a_tabs[3]->setItemDelegateForColumn(1, new ProxyRelationalDelegate(a_tabs[3]));
+
+	int tab = QSettings().value("tabelle/tab", 0).toInt();
+	if (tab < 0 || tab >= 7)
+		tab = 0;
+	a_tabWidget->setCurrentIndex(tab);
+	m_activate(tab);
+}
+
+/*!
+ * \brief Richtet das Datenmodell eines Tabs ein und lädt es zum ersten Mal
+ * \param tab Index des Tabs
+ *
+ * Wird erst aufgerufen, wenn der Tab zum ersten Mal angezeigt wird, damit beim Start nicht alle Tabellen
+ * (insbesondere die Ausleihen mit ihren Joins) geladen werden müssen. Die Ausleih-Tabs verknüpfen ihre
+ * Tabellen mit denselben Aliasnamen (relTblAl_n), die zuvor QSqlRelationalTableModel erzeugt hat, damit
+ * die Filter aus FindDialog::getFilter() weiter passen.
+ */
+void TableView::m_activate(int tab) {
+	if (a_activated[tab])
+		return;
+	a_activated[tab] = true;
+
+	switch (tab) {
+	case 0:
+		a_lendings[0]->setStatement(QStringList() << "relTblAl_0.`Klasse`" << "relTblAl_1.`Name`"
+					    << "relTblAl_2.`titel`" << "`Sausleihe`.`anz`" << "`Sausleihe`.`adatum`",
+					    "`Sausleihe` JOIN `SSchueler` relTblAl_0 ON relTblAl_0.`id` = `Sausleihe`.`a` "
+					    "JOIN `SSchueler` relTblAl_1 ON relTblAl_1.`id` = `Sausleihe`.`b` "
+					    "JOIN `Buch` relTblAl_2 ON relTblAl_2.`isbn` = `Sausleihe`.`bid`",
+					    QStringList() << "`Sausleihe`.`a`" << "`Sausleihe`.`bid`", "sausleihe");
+		a_lendings[0]->setHeaderData(0, Qt::Horizontal, tr("Klasse"));
+		a_lendings[0]->setHeaderData(1, Qt::Horizontal, tr("Schüler"));
+		a_lendings[0]->setHeaderData(2, Qt::Horizontal, tr("Buch"));
+		a_lendings[0]->setHeaderData(3, Qt::Horizontal, tr("Anzahl"));
+		a_lendings[0]->setHeaderData(4, Qt::Horizontal, tr("Datum"));
+		break;
+	case 1:
+		a_lendings[1]->setStatement(QStringList() << "relTblAl_0.`name`" << "relTblAl_1.`titel`"
+					    << "`lausleihe`.`anz`" << "`lausleihe`.`adatum`",
+					    "`lausleihe` JOIN `lehrer` relTblAl_0 ON relTblAl_0.`id` = `lausleihe`.`lid` "
+					    "JOIN `Buch` relTblAl_1 ON relTblAl_1.`isbn` = `lausleihe`.`bid`",
+					    QStringList() << "`lausleihe`.`lid`" << "`lausleihe`.`bid`", "lausleihe");
+		a_lendings[1]->setHeaderData(0, Qt::Horizontal, tr("Lehrer"));
+		a_lendings[1]->setHeaderData(1, Qt::Horizontal, tr("Buch"));
+		a_lendings[1]->setHeaderData(2, Qt::Horizontal, tr("Anzahl"));
+		a_lendings[1]->setHeaderData(3, Qt::Horizontal, tr("Datum"));
+		break;
+	case 2:
+		a_lendings[2]->setStatement(QStringList() << "relTblAl_0.`Klasse`" << "relTblAl_1.`Name`"
+					    << "relTblAl_2.`titel`" << "`Btausch`.`datum`",
+					    "`Btausch` JOIN `SSchueler` relTblAl_0 ON relTblAl_0.`id` = `Btausch`.`a` "
+					    "JOIN `SSchueler` relTblAl_1 ON relTblAl_1.`id` = `Btausch`.`b` "
+					    "JOIN `Buch` relTblAl_2 ON relTblAl_2.`isbn` = `Btausch`.`bid`",
+					    QStringList() << "`Btausch`.`a`" << "`Btausch`.`bid`", "btausch");
+		a_lendings[2]->setHeaderData(0, Qt::Horizontal, tr("Klasse"));
+		a_lendings[2]->setHeaderData(1, Qt::Horizontal, tr("Schüler"));
+		a_lendings[2]->setHeaderData(2, Qt::Horizontal, tr("Buch"));
+		a_lendings[2]->setHeaderData(3, Qt::Horizontal, tr("Datum"));
+		break;
+	case 3: {
+		QSqlRelationalTableModel *m = qobject_cast<QSqlRelationalTableModel *>(a_models[3]);
+		m->setTable("aliasse");
+		m->setHeaderData(0, Qt::Horizontal, tr("Alias"));
+		m->setHeaderData(1, Qt::Horizontal, tr("Buch"));
+		m->setRelation(1, QSqlRelation("Buch", "isbn", "titel"));
+		m->setEditStrategy(QSqlTableModel::OnFieldChange);
+		break;
+	}
+	case 4:
+		a_models[4]->setTable("schueler");
+		a_models[4]->setHeaderData(0, Qt::Horizontal, tr("id"));
+		a_models[4]->setHeaderData(1, Qt::Horizontal, tr("Name"));
+		a_models[4]->setHeaderData(2, Qt::Horizontal, tr("Abschlussjahr"));
+		a_models[4]->setHeaderData(3, Qt::Horizontal, tr("Klassenbuchstabe"));
+		a_models[4]->setEditStrategy(QSqlTableModel::OnFieldChange);
+		break;
+	case 5:
+		a_models[5]->setTable("lehrer");
+		a_models[5]->setHeaderData(0, Qt::Horizontal, tr("id"));
+		a_models[5]->setHeaderData(1, Qt::Horizontal, tr("Name"));
+		a_models[5]->setHeaderData(2, Qt::Horizontal, tr("Kürzel"));
+		a_models[5]->setEditStrategy(QSqlTableModel::OnFieldChange);
+		break;
+	case 6:
+		a_models[6]->setTable("buch");
+		a_models[6]->setHeaderData(0, Qt::Horizontal, tr("ISBN"));
+		a_models[6]->setHeaderData(1, Qt::Horizontal, tr("Titel"));
+		a_models[6]->setHeaderData(2, Qt::Horizontal, tr("Jgst."));
+		a_models[6]->setEditStrategy(QSqlTableModel::OnFieldChange);
+		break;
+	}
+
+	if (tab < 3) {
+		a_tabs[tab]->setModel(a_lendings[tab]);
+	} else {
+		a_proxies[tab]->setSourceModel(a_models[tab]);
+		a_tabs[tab]->setModel(a_proxies[tab]);
+	}
+
+	// Die Sortierung übernimmt sortChanged(), nicht QTableView::setSortingEnabled(), sonst würde doppelt sortiert
+	QHeaderView *header = a_tabs[tab]->horizontalHeader();
+	header->setSectionsClickable(true);
+	header->setSortIndicatorShown(true);
+	// Die Ausleih-Tabs beginnen in der Reihenfolge des Primärschlüssels; ihre erste Spalte ist teils berechnet
+	header->blockSignals(true);
+	header->setSortIndicator(tab < 3 ? -1 : 0, Qt::AscendingOrder);
+	header->blockSignals(false);
+	if (tab < 3)
+		m_sort(tab, -1, Qt::AscendingOrder);
+	else
+		m_selectModel(tab);
 }
 
 /*!
@@ -160,8 +302,16 @@ void TableView::m_setInitialValues() {
 void TableView::m_connectComponents() {
 	connect(a_tabWidget, SIGNAL(currentChanged(int)), this, SLOT(changeTab(int)));
 	for (int i = 0; i < 7; ++i)
-		connect(a_tabs[i]->horizontalHeader(), SIGNAL(clicked(QModelIndex)),
-			this, SLOT(headerClicked(QModelIndex)));
+		connect(a_tabs[i]->horizontalHeader(), SIGNAL(sortIndicatorChanged(int,Qt::SortOrder)),
+			this, SLOT(sortChanged(int,Qt::SortOrder)));
+	for (int i = 0; i < 3; ++i) {
+		connect(a_lendings[i], SIGNAL(loaded()), this, SLOT(lendingsLoaded()));
+		connect(a_lendings[i], SIGNAL(estimated(int)), this, SLOT(lendingsEstimated(int)));
+	}
+	connect(a_models[3], SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(booksEdited()));
+	connect(a_models[6], SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(booksEdited()));
+	connect(a_models[4], SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(peopleEdited()));
+	connect(a_models[5], SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(peopleEdited()));
 }
 
 /*!
@@ -171,6 +321,7 @@ void TableView::m_connectComponents() {
  * aktuelle Tab neu geladen.
  */
 void TableView::lendBook() {
+	TraceScope trace("action", "TableView::lendBook");
 	InsertDialog *dl = new InsertDialog(false, this);
 	dl->setFocus();
 	dl->exec();
@@ -185,6 +336,7 @@ void TableView::lendBook() {
  * lendBook() der aktuelle Tab neu geladen.
  */
 void TableView::withdrawBook() {
+	TraceScope trace("action", "TableView::withdrawBook");
 	DeleteDialog *dl = new DeleteDialog(false, this);
 	dl->setFocus();
 	dl->exec();
@@ -197,14 +349,17 @@ void TableView::withdrawBook() {
  * \brief Fügt einen neuen Datensatz ein
  *
  * Zuerst wird ein neuer InsertionDialog erzeugt und angezeigt. Danach wird der aktuelle Tab neu
- * geladen und der Dialog wieder gelöscht.
+ * geladen, der Dialog wieder gelöscht und der PersonIndex neu geladen, falls ein Schüler oder Lehrer
+ * eingefügt wurde. Neue Bücher und Aliasse trägt der InsertionDialog selbst in den BookIndex ein.
  */
 void TableView::insertRecord() {
 	InsertionDialog *dlg = new InsertionDialog(tabIndex() - 3, this);
 	dlg->setFocus();
-	dlg->exec();
+	bool accepted = dlg->exec() == QDialog::Accepted;
 	delete dlg;
 	refresh();
+	if (accepted && (tabIndex() == 4 || tabIndex() == 5))
+		peopleEdited();
 }
 
 /*!
@@ -214,11 +369,17 @@ void TableView::insertRecord() {
  * aufgerufen.
  */
 void TableView::deleteRecord() {
+	if (tabIndex() < 3)
+		return;
 	if (a_tabs[tabIndex()]->selectionModel()->selectedRows().isEmpty())
 		return;
-	int row = a_tabs[tabIndex()]->selectionModel()->selectedRows()[0].row();
-	a_models[tabIndex()]->removeRow(row);
+	QModelIndex index = a_tabs[tabIndex()]->selectionModel()->selectedRows()[0];
+	a_models[tabIndex()]->removeRow(a_proxies[tabIndex()]->mapToSource(index).row());
 	refresh();
+	if (tabIndex() == 3 || tabIndex() == 6)
+		booksEdited();
+	if (tabIndex() == 4 || tabIndex() == 5)
+		peopleEdited();
 }
 
 /*!
@@ -233,7 +394,7 @@ void TableView::find() {
 	FindDialog *dlg = new FindDialog(a_tabWidget->currentIndex(), this);
 	dlg->setFocus();
 	if (dlg->exec() && !(query = dlg->getFilter()).isEmpty())
-		a_models[dlg->getIndex()]->setFilter(query);
+		m_setFilter(dlg->getIndex(), query);
 	delete dlg;
 	refresh();
 //	QMessageBox::information(0, tr("Last Query"), a_models[tabIndex()]->query().lastQuery());
@@ -247,7 +408,7 @@ void TableView::find() {
  */
 void TableView::reset(){
 	Q_ASSERT(tabIndex() >= 0);
-	a_models[tabIndex()]->setFilter(QString());
+	m_setFilter(tabIndex(), QString());
 	refresh();
 }
 
@@ -265,41 +426,82 @@ void TableView::showSettings() {
 /*!
  * \brief Aktualisiert die Ansicht
  *
- * Ruft die refresh()-Methode des aktuellen Tabs auf
+ * Lädt die Daten des aktuellen Tabs neu
+ * \see m_select()
  */
 void TableView::refresh() {
 	Q_ASSERT(tabIndex() >= 0);
-	a_models[tabIndex()]->select();
-	a_tabs[tabIndex()]->resizeColumnsToContents();
+	TraceScope trace("model", QString("TableView::refresh %1").arg(tabIndex()));
+	m_select(tabIndex());
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn Aliasse oder Bücher in der Tabelle bearbeitet oder gelöscht wurden
+ *
+ * Der BookIndex wird im Hintergrund neu geladen, damit die Dialoge wieder aktuelle Daten haben.
+ */
+void TableView::booksEdited() {
+	BookIndex::instance()->reload();
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn Schüler oder Lehrer eingefügt, bearbeitet oder gelöscht wurden
+ *
+ * Der PersonIndex wird im Hintergrund neu geladen, damit SelectDialog wieder aktuelle Namen findet.
+ */
+void TableView::peopleEdited() {
+	PersonIndex::instance()->reload();
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn ein Ausleih-Tab seine Daten im Hintergrund geladen hat
+ *
+ * Die Spaltenbreiten des betreffenden Tabs werden angepasst; gemessen wird nur beim ersten Laden, weitere
+ * Seiten übernehmen die gespeicherten Breiten (siehe ColumnSizer).
+ */
+void TableView::lendingsLoaded() {
+	for (int i = 0; i < 3; ++i)
+		if (a_lendings[i] == sender())
+			a_sizer.fit(a_tabs[i], i);
+}
+
+/*!
+ * \brief Wird aufgerufen, wenn für einen Ausleih-Tab die Zahl der Zeilen geschätzt wurde
+ * \param rows Geschätzte Anzahl der Zeilen
+ *
+ * Die Schätzung wird über statusMessage() angezeigt, da die Tabelle selbst nur die geladenen Seiten kennt.
+ */
+void TableView::lendingsEstimated(int rows) {
+	for (int i = 0; i < 3; ++i)
+		if (a_lendings[i] == sender() && i == tabIndex())
+			emit statusMessage(tr("ca. %1 Datensätze").arg(rows));
 }
 
 /*!
  * \brief Wird aufgerufen, wenn ein anderer Tab ausgewählt wurde
  * \param index Index des neuen aktuellen Tabs
  *
- * Es wird tabChanged() emittiert.
+ * Der Tab wird in den Einstellungen gespeichert und tabChanged() emittiert. Das daraufhin von View
+ * ausgelöste refresh() richtet einen zum ersten Mal angezeigten Tab ein (siehe m_select()).
  */
 void TableView::changeTab(int index) {
+	if (index < 0)
+		return;
+	QSettings().setValue("tabelle/tab", index);
 	emit tabChanged(index);
 }
 
 /*!
- * \brief Wird aufgerufen, wenn der Header des aktuellen Tabs angeklickt wurde
- * \param index Headerspalte
- *
+ * \brief Wird aufgerufen, wenn im Header eines Tabs die Sortierung geändert wurde
+ * \param column Spalte, nach der sortiert werden soll
+ * \param order Reihenfolge
  *
+ * Der Header kehrt die Sortierreihenfolge beim Klick selbst um; hier wird nur noch sortiert.
  */
-void TableView::headerClicked(QModelIndex index) {
-	Qt::SortOrder order;
-	if (a_tabs[tabIndex()]->horizontalHeader()->sortIndicatorSection() ==
-			index.column())
-		order = (a_tabs[tabIndex()]->horizontalHeader()->sortIndicatorOrder() == Qt::AscendingOrder) ?
-					Qt::DescendingOrder : Qt::AscendingOrder;
-	else
-		order = Qt::AscendingOrder;
-	a_models[tabIndex()]->sort(index.column(), order);
-	a_models[tabIndex()]->select();
-	a_tabs[tabIndex()]->horizontalHeader()->setSortIndicator(index.column(), order);
+void TableView::sortChanged(int column, Qt::SortOrder order) {
+	for (int i = 0; i < 7; ++i)
+		if (a_tabs[i]->horizontalHeader() == sender() && a_activated[i])
+			m_sort(i, column, order);
 }
 
 /*!
@@ -312,4 +514,5 @@ void TableView::import() {
 	dlg->exec();
 	delete dlg;
 	refresh();
+	peopleEdited();
 }
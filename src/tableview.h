@@ -2,6 +2,9 @@
 #define TABLEVIEW_H
 
 #include "main.h"
+#include "pagedmodel.h"
+#include "sortproxy.h"
+#include "columnsizer.h"
 #include <QMainWindow>
 #include <QDockWidget>
 #include <QMenuBar>
@@ -32,12 +35,22 @@ class TableView : public QWidget {
 private:
 	QTabWidget *a_tabWidget;                 ///< Komprimiert die Anzeige der Tabellen
 	QTableView *a_tabs[7];                   ///< Enthält die einzelnen Tabs
-	QSqlTableModel *a_models[7];
+	PagedModel *a_lendings[3];               ///< Datenmodelle der Ausleih-Tabs (laden seitenweise im Hintergrund)
+	QSqlTableModel *a_models[7];             ///< Datenmodelle der bearbeitbaren Tabs (ab Index 3)
+	SortProxy *a_proxies[7];                 ///< Sortieren die bearbeitbaren Tabs im Speicher (ab Index 3)
+	bool a_activated[7];                     ///< Wurde der Tab schon eingerichtet und geladen?
+	ColumnSizer a_sizer;                     ///< Passt die Spaltenbreiten der Tabs an
 
 	void m_createComponents();
 	void m_alignComponents();
 	void m_setInitialValues();
 	void m_connectComponents();
+	void m_activate(int tab);
+	QString m_filter(int tab) const;
+	void m_setFilter(int tab, QString filter);
+	void m_select(int tab);
+	void m_selectModel(int tab);
+	void m_sort(int tab, int column, Qt::SortOrder order);
 
 public:
 	TableView(QWidget *parent = 0);
@@ -46,7 +59,11 @@ public:
 
 private slots:
 	void changeTab(int index);
-	void headerClicked(QModelIndex index);
+	void sortChanged(int column, Qt::SortOrder order);
+	void lendingsLoaded();
+	void lendingsEstimated(int rows);
+	void booksEdited();
+	void peopleEdited();
 
 public slots:
 	void lendBook();
@@ -61,6 +78,7 @@ public slots:
 
 signals:
 	void tabChanged(int index);
+	void statusMessage(QString message);
 };
 
 
@@ -0,0 +1,181 @@
+#include "tracer.h"
+#include "watchdog.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+Tracer *Tracer::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von Tracer
+ * \param fileName Ausgabedatei; sie wird überschrieben
+ *
+ * Lässt sich die Datei nicht anlegen, bleibt das Tracing ausgeschaltet.
+ */
+Tracer::Tracer(QString fileName) : a_empty(true) {
+	a_file.setFileName(fileName);
+	if (!a_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning("Trace-Datei %s kann nicht angelegt werden", qPrintable(fileName));
+		return;
+	}
+	a_file.write("[");
+	a_clock.start();
+	s_instance = this;
+}
+
+/*!
+ * \brief Destruktor von Tracer
+ *
+ * Schließt das JSON-Array ab.
+ */
+Tracer::~Tracer() {
+	if (s_instance != this)
+		return;
+	s_instance = 0;
+	QMutexLocker locker(&a_mutex);
+	a_file.write("\n]\n");
+	a_file.close();
+}
+
+/*!
+ * \brief Gibt die aktuelle Zeit des Tracers an
+ * \return Nanosekunden seit dem Start des Tracers, -1 bei ausgeschaltetem Tracing
+ */
+qint64 Tracer::now() {
+	Tracer *tracer = s_instance;
+	return tracer ? tracer->a_clock.nsecsElapsed() : -1;
+}
+
+/*!
+ * \brief Gibt die Spur des aktuellen Threads an
+ * \return Nummer der Spur
+ *
+ * Beim ersten Ereignis eines Threads wird dessen Name als Metadaten-Ereignis geschrieben. Muss mit
+ * gesperrtem a_mutex aufgerufen werden.
+ */
+int Tracer::m_thread() {
+	Qt::HANDLE handle = QThread::currentThreadId();
+	QHash<Qt::HANDLE, int>::const_iterator i = a_threads.constFind(handle);
+	if (i != a_threads.constEnd())
+		return i.value();
+
+	int tid = a_threads.size() + 1;
+	a_threads.insert(handle, tid);
+	QThread *thread = QThread::currentThread();
+	QString name = thread->objectName();
+	if (qApp && thread == qApp->thread())
+		name = "GUI";
+	else if (name.isEmpty())
+		name = QString("Thread %1").arg(tid);
+
+	QVariantMap args;
+	args["name"] = name;
+	QVariantMap event;
+	event["ph"] = "M";
+	event["name"] = "thread_name";
+	event["pid"] = QCoreApplication::applicationPid();
+	event["tid"] = tid;
+	event["args"] = args;
+	m_write(event);
+	return tid;
+}
+
+/*!
+ * \brief Schreibt ein Ereignis in die Datei
+ * \param event Ereignis
+ *
+ * Muss mit gesperrtem a_mutex aufgerufen werden.
+ */
+void Tracer::m_write(QVariantMap event) {
+	a_file.write(a_empty ? "\n" : ",\n");
+	a_file.write(QJsonDocument(QJsonObject::fromVariantMap(event)).toJson(QJsonDocument::Compact));
+	a_empty = false;
+}
+
+/*!
+ * \brief Ergänzt die gemeinsamen Felder eines Ereignisses und schreibt es
+ * \param phase Art des Ereignisses ('X', 'b', 'e')
+ * \param category Kategorie
+ * \param name Name
+ * \param ts Zeitpunkt nach now()
+ * \param fields Weitere Felder (dur, id, args)
+ */
+void Tracer::m_event(char phase, const char *category, const QString &name, qint64 ts, QVariantMap fields) {
+	fields["ph"] = QString(QLatin1Char(phase));
+	fields["cat"] = category;
+	fields["name"] = name;
+	fields["ts"] = ts / 1000.0;
+	fields["pid"] = QCoreApplication::applicationPid();
+	QMutexLocker locker(&a_mutex);
+	fields["tid"] = m_thread();
+	m_write(fields);
+}
+
+/*!
+ * \brief Schreibt ein abgeschlossenes Ereignis des aktuellen Threads
+ * \param category Kategorie
+ * \param name Name
+ * \param start Beginn nach now()
+ * \param end Ende nach now()
+ * \param args Zusätzliche Angaben, die beim Anklicken des Ereignisses angezeigt werden
+ */
+void Tracer::complete(const char *category, const QString &name, qint64 start, qint64 end, QVariantMap args) {
+	Tracer *tracer = s_instance;
+	if (!tracer || start < 0)
+		return;
+	QVariantMap fields;
+	fields["dur"] = qMax(end - start, qint64(0)) / 1000.0;
+	if (!args.isEmpty())
+		fields["args"] = args;
+	tracer->m_event('X', category, name, start, fields);
+}
+
+/*!
+ * \brief Beginnt ein asynchrones Ereignis, das auch in einem anderen Thread enden darf
+ * \param category Kategorie
+ * \param name Name
+ * \param id Kennung, über die asyncEnd() das Ereignis zuordnet (z.B. die Auftragsnummer)
+ */
+void Tracer::asyncBegin(const char *category, const QString &name, qint64 id) {
+	Tracer *tracer = s_instance;
+	if (!tracer)
+		return;
+	QVariantMap fields;
+	fields["id"] = id;
+	tracer->m_event('b', category, name, tracer->a_clock.nsecsElapsed(), fields);
+}
+
+/*!
+ * \brief Beendet ein asynchrones Ereignis
+ * \see asyncBegin()
+ */
+void Tracer::asyncEnd(const char *category, const QString &name, qint64 id) {
+	Tracer *tracer = s_instance;
+	if (!tracer)
+		return;
+	QVariantMap fields;
+	fields["id"] = id;
+	tracer->m_event('e', category, name, tracer->a_clock.nsecsElapsed(), fields);
+}
+
+/*!
+ * \brief Konstruktor von TraceScope
+ * \param category Kategorie
+ * \param name Name des Ereignisses
+ */
+TraceScope::TraceScope(const char *category, QString name) : a_category(category), a_name(name),
+	a_start(Tracer::now()), a_scope(Watchdog::scope(category)) {
+	a_previous = Watchdog::enter(a_scope, a_name);
+}
+
+/*!
+ * \brief Destruktor von TraceScope
+ *
+ * Schreibt das Ereignis vom Konstruktor bis jetzt und stellt den vorher aktiven Bereich wieder her.
+ */
+TraceScope::~TraceScope() {
+	Watchdog::enter(a_scope, a_previous);
+	Tracer::complete(a_category, a_name, a_start, Tracer::now());
+}
@@ -0,0 +1,65 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <QFile>
+
+/*!
+ * \brief Schreibt eine Zeitleiste im Trace-Event-Format von Chrome
+ *
+ * Die Datei lässt sich in chrome://tracing oder https://ui.perfetto.dev öffnen. Sie ist ein JSON-Array,
+ * das erst im Destruktor geschlossen wird; beide Werkzeuge lesen aber auch die Datei eines abgestürzten
+ * Programms. Ohne Instanz (Tracing ausgeschaltet) kostet jeder Aufruf nur einen Zeigervergleich.
+ * Wird aus mehreren Threads benutzt; jeder Thread erhält eine eigene Spur.
+ */
+class Tracer {
+private:
+	static Tracer *s_instance;               ///< Die Instanz der Anwendung (0 - Tracing ausgeschaltet)
+	QElapsedTimer a_clock;                   ///< Zeitbasis aller Ereignisse
+	QMutex a_mutex;                          ///< Schützt alle folgenden Attribute
+	QFile a_file;                            ///< Ausgabedatei
+	bool a_empty;                            ///< Wurde noch kein Ereignis geschrieben?
+	QHash<Qt::HANDLE, int> a_threads;        ///< Zuordnung Thread->Nummer der Spur
+
+	int m_thread();
+	void m_write(QVariantMap event);
+	void m_event(char phase, const char *category, const QString &name, qint64 ts, QVariantMap fields);
+
+public:
+	Tracer(QString fileName);
+	~Tracer();
+	static Tracer *instance() {return s_instance;}
+	static qint64 now();
+	static void complete(const char *category, const QString &name, qint64 start, qint64 end,
+			     QVariantMap args = QVariantMap());
+	static void asyncBegin(const char *category, const QString &name, qint64 id);
+	static void asyncEnd(const char *category, const QString &name, qint64 id);
+};
+
+/*!
+ * \brief Meldet die Lebensdauer eines Blocks als Ereignis an den Tracer
+ *
+ * Beispiel: TraceScope trace("action", "TableView::lendBook"); am Anfang einer Funktion.
+ * Als Attribut eines Dialogs erfasst es dessen Lebensdauer vom Konstruktor bis zum Destruktor.
+ * Aktionen und Dialoge im GUI-Thread werden außerdem dem Watchdog als aktiver Bereich gemeldet.
+ */
+class TraceScope {
+private:
+	const char *a_category;                  ///< Kategorie (action, dialog, model, sql, ...)
+	QString a_name;                          ///< Name des Ereignisses
+	qint64 a_start;                          ///< Beginn nach Tracer::now() (-1: Tracing ausgeschaltet)
+	int a_scope;                             ///< Art des Bereichs für den Watchdog (-1: keiner)
+	QString a_previous;                      ///< Vorher aktiver Bereich derselben Art
+
+	Q_DISABLE_COPY(TraceScope)
+
+public:
+	TraceScope(const char *category, QString name);
+	~TraceScope();
+};
+
+#endif
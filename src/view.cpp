@@ -2,6 +2,9 @@
 #include "insertdlg.h"
 #include "deletedlg.h"
 #include "settingsdlg.h"
+#include "executor.h"
+#include "bookindex.h"
+#include "diagnosticsdlg.h"
 #include <QtCore>
 #include <QtGui>
 #include <QtWidgets>
@@ -28,6 +31,7 @@ void View::m_createComponents() {
 	a_list = new ListView;
 	a_tools = addToolBar(tr("Werkzeuge"));
 	a_status = statusBar();
+	a_busy = new QProgressBar;
 
 	a_menuLend = menuBar()->addMenu(tr("&Ausleihe"));
 	a_menuEdit = menuBar()->addMenu(tr("&Bearbeiten"));
@@ -40,6 +44,7 @@ void View::m_createComponents() {
 	a_about = new QAction(tr("Ü&ber Obsidian..."), this);
 	a_aboutQt = new QAction(tr("Über &Qt..."), this);
 	a_doc = new QAction(QIcon(":/images/hilfe.png"), tr("&Dokumentation anzeigen..."), this);
+	a_diagnostics = new QAction(tr("Dia&gnose..."), this);
 	a_find = new QAction(QIcon(":/images/suchen.png"), tr("&Suchen..."), this);
 	a_insert = new QAction(QIcon(":/images/einfuegen.png"), tr("&Einfügen..."), this);
 	a_delete = new QAction(QIcon(":/images/loeschen.png"), tr("&Löschen"), this);
@@ -48,6 +53,7 @@ void View::m_createComponents() {
 	a_refresh = new QAction(QIcon(":/images/aktualisieren.png"), tr("&Aktualisieren"), this);
 	a_import = new QAction(tr("Schülerdaten i&mportieren..."), this);
 	a_export = new QAction(tr("Ausleihen e&xportieren..."), this);
+	a_reloadBooks = new QAction(tr("&Bücherverzeichnis neu laden"), this);
 	a_tableView = new QAction(tr("&Tabellenansicht"), this);
 	a_listView = new QAction(tr("&Listenansicht"), this);
 }
@@ -67,6 +73,7 @@ void View::m_alignComponents() {
 	a_menuEdit->addAction(a_find);
 	a_menuEdit->addAction(a_reset);
 	a_menuEdit->addAction(a_refresh);
+	a_menuEdit->addAction(a_reloadBooks);
 	a_menuEdit->addSeparator();
 	a_menuEdit->addAction(a_settings);
 
@@ -80,6 +87,7 @@ void View::m_alignComponents() {
 	a_menuHelp->addAction(a_aboutQt);
 	a_menuHelp->addSeparator();
 	a_menuHelp->addAction(a_doc);
+	a_menuHelp->addAction(a_diagnostics);
 
 	a_tools->addAction(a_lend);
 	a_tools->addAction(a_withdraw);
@@ -116,6 +124,7 @@ void View::m_setInitialValues() {
 	a_about->setStatusTip(tr("Zeigt Informationen über Obsidian an"));
 	a_aboutQt->setStatusTip(tr("Zeigt Informationen über Qt an"));
 	a_doc->setStatusTip(tr("Zeigt die (hoffentlich nicht so schlechte) Dokumentation an"));
+	a_diagnostics->setStatusTip(tr("Zeigt an, wo das Programm hängt und wie lange die Datenbankabfragen dauern"));
 	a_find->setStatusTip(tr("Öffnet den Suchen-Dialog"));
 	a_insert->setStatusTip(tr("Fügt einen neuen Datensatz ein"));
 	a_delete->setStatusTip(tr("Löscht einen Datensatz"));
@@ -124,6 +133,7 @@ void View::m_setInitialValues() {
 	a_refresh->setStatusTip(tr("Lädt die aktuelle Ansicht neu"));
 	a_import->setStatusTip(tr("Importiert Schülerdaten aus einer CSV-Datei"));
 	a_export->setStatusTip(tr("Erstellt eine Liste mit den zurückzugebenden Ausleihen einer Klasse"));
+	a_reloadBooks->setStatusTip(tr("Lädt die Bücher und Aliasse für das Einscannen neu"));
 	a_tableView->setStatusTip(tr("Wechselt in die Tabellen-Ansicht"));
 	a_listView->setStatusTip(tr("Wechselt in die Listenansicht"));
 
@@ -146,6 +156,11 @@ void View::m_setInitialValues() {
 	a_showsTable = true;
 	m_updateMenus();
 	a_tools->setAllowedAreas(Qt::TopToolBarArea);
+	a_busy->setRange(0, 0);
+	a_busy->setMaximumWidth(120);
+	a_busy->setStatusTip(tr("Es werden Daten im Hintergrund geladen"));
+	a_busy->setVisible(QueryExecutor::instance()->isBusy());
+	a_status->addPermanentWidget(a_busy);
 	setWindowTitle(tr("Obsidian — Tabellenansicht"));
 }
 
@@ -158,6 +173,7 @@ void View::m_connectComponents() {
 	connect(a_about, SIGNAL(triggered()), this, SLOT(showAbout()));
 	connect(a_aboutQt, SIGNAL(triggered()), qApp, SLOT(aboutQt()));
 	connect(a_doc, SIGNAL(triggered()), this, SLOT(showDoc()));
+	connect(a_diagnostics, SIGNAL(triggered()), this, SLOT(showDiagnostics()));
 	connect(a_find, SIGNAL(triggered()), this, SLOT(find()));
 	connect(a_insert, SIGNAL(triggered()), a_table, SLOT(insertRecord()));
 	connect(a_delete, SIGNAL(triggered()), a_table, SLOT(deleteRecord()));
@@ -166,9 +182,12 @@ void View::m_connectComponents() {
 	connect(a_refresh, SIGNAL(triggered()), this, SLOT(refresh()));
 	connect(a_import, SIGNAL(triggered()), a_table, SLOT(import()));
 	connect(a_export, SIGNAL(triggered()), a_list, SLOT(exportLendings()));
+	connect(a_reloadBooks, SIGNAL(triggered()), BookIndex::instance(), SLOT(reload()));
 	connect(a_tableView, SIGNAL(toggled(bool)), this, SLOT(toggle()));
 //	connect(a_listView, SIGNAL(toggled(bool)), this, SLOT(toggle()));
 	connect(a_table, SIGNAL(tabChanged(int)), this, SLOT(refresh()));
+	connect(a_table, SIGNAL(statusMessage(QString)), a_status, SLOT(showMessage(QString)));
+	connect(QueryExecutor::instance(), SIGNAL(busyChanged(bool)), a_busy, SLOT(setVisible(bool)));
 }
 
 /*!
@@ -231,10 +250,20 @@ void View::showDoc() {
 	pdfViewer->start(PDF_VIEWER, arguments);
 }
 
+/*!
+ * \brief Zeigt die Hänger des GUI-Threads und die Laufzeiten der Statements an
+ */
+void View::showDiagnostics() {
+	DiagnosticsDialog *dlg = new DiagnosticsDialog(this);
+	dlg->exec();
+	delete dlg;
+}
+
 /*!
  * \brief Sucht einen Datensatz
  */
 void View::find() {
+	TraceScope trace("action", "View::find");
 	Q_ASSERT(a_showsTable);
 	a_table->find();
 	m_updateMenus();
@@ -244,6 +273,7 @@ void View::find() {
  * \brief Lädt alles neu
  */
 void View::refresh() {
+	TraceScope trace("action", "View::refresh");
 	if (a_showsTable)
 		a_table->refresh();
 	else
@@ -255,6 +285,7 @@ void View::refresh() {
  * \brief Schaltet zwischen Tabellen- und Listenansicht um
  */
 void View::toggle() {
+	TraceScope trace("action", "View::toggle");
 	if (a_showsTable) {
 		qobject_cast<QStackedLayout *>(centralWidget()->layout())->setCurrentIndex(1);
 		setWindowTitle(tr("Obsidian — Listenansicht (Bücherumtausch)"));
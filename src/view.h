@@ -4,6 +4,7 @@
 #include "tableview.h"
 #include "listview.h"
 #include <QMainWindow>
+#include <QProgressBar>
 
 class View : public QMainWindow
 {
@@ -14,6 +15,7 @@ private:
 	ListView *a_list;                        ///< Listenansicht
 	QToolBar *a_tools;                       ///< ToolBar
 	QStatusBar *a_status;                    ///< StatusBar
+	QProgressBar *a_busy;                    ///< Zeigt an, dass im Hintergrund Abfragen laufen
 	QMenu *a_menuLend;                       ///< Ausleih-Menü
 	QMenu *a_menuHelp;                       ///< Hilfe-Menü
 	QMenu *a_menuEdit;                       ///< Bearbeiten-Menü
@@ -23,6 +25,7 @@ private:
 	QAction *a_about;                        ///< Hilfe|Über
 	QAction *a_aboutQt;                      ///< Hilfe|Über Qt
 	QAction *a_doc;                          ///< Hilfe|Dokumentation anzeigen
+	QAction *a_diagnostics;                  ///< Hilfe|Diagnose
 	QAction *a_find;                         ///< Bearbeiten|Suchen
 	QAction *a_insert;                       ///< Bearbeiten|Einfügen
 	QAction *a_delete;                       ///< Bearbeiten|Löschen
@@ -30,6 +33,7 @@ private:
 	QAction *a_settings;                     ///< Bearbeiten|Einstellungen
 	QAction *a_refresh;                      ///< Bearbeiten|Aktualisieren
 	QAction *a_import;                       ///< Bearbeiten|Importieren
+	QAction *a_reloadBooks;                  ///< Bearbeiten|Bücherverzeichnis neu laden
 	QAction *a_export;                       ///< Bearbeiten|Exportieren
 	QAction *a_tableView;                    ///< Ansicht|Tabellenansicht
 	QAction *a_listView;                     ///< Ansicht|Listenansicht
@@ -46,6 +50,7 @@ public:
 private slots:
 	void showAbout();
 	void showDoc();
+	void showDiagnostics();
 	void find();
 	void refresh();
 	void toggle();
@@ -0,0 +1,213 @@
+#include "watchdog.h"
+#include "querystats.h"
+#include "tracer.h"
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QTextStream>
+#include <QStringList>
+
+Watchdog *Watchdog::s_instance = 0;
+
+/*!
+ * \brief Konstruktor von Watchdog
+ * \param logFile Log, an das die Hänger angehängt werden ("" - kein Log)
+ * \param thresholdMs Ab dieser Dauer in Millisekunden gilt der GUI-Thread als hängend
+ * \param parent Elternobjekt
+ *
+ * Muss im GUI-Thread erzeugt werden; startet Herzschlag und Watchdog-Thread sofort.
+ */
+Watchdog::Watchdog(QString logFile, int thresholdMs, QObject *parent) : QThread(parent),
+	a_threshold(qint64(thresholdMs) * 1000000), a_stop(false), a_lastBeat(0), a_stalled(false), a_stalls(0),
+	a_stallTotal(0) {
+	setObjectName("Watchdog");
+	if (!logFile.isEmpty()) {
+		a_log.setFileName(logFile);
+		if (!a_log.open(QIODevice::Append | QIODevice::Text))
+			qWarning("Log %s kann nicht geöffnet werden", qPrintable(logFile));
+	}
+	a_clock.start();
+	s_instance = this;
+
+	a_heartbeat.setInterval(a_interval);
+	connect(&a_heartbeat, SIGNAL(timeout()), this, SLOT(beat()));
+	a_heartbeat.start();
+	start(QThread::LowPriority);
+}
+
+/*!
+ * \brief Destruktor von Watchdog
+ *
+ * Beendet den Watchdog-Thread und wartet auf ihn.
+ */
+Watchdog::~Watchdog() {
+	{
+		QMutexLocker locker(&a_mutex);
+		a_stop = true;
+		a_wake.wakeAll();
+	}
+	wait();
+	if (s_instance == this)
+		s_instance = 0;
+}
+
+/*!
+ * \brief Gibt an, welche Art von Bereich eine TraceScope-Kategorie ist
+ * \param category Kategorie
+ * \return Scope oder -1, wenn die Kategorie nicht überwacht wird
+ */
+int Watchdog::scope(const char *category) {
+	if (qstrcmp(category, "action") == 0)
+		return Action;
+	if (qstrcmp(category, "dialog") == 0)
+		return Dialog;
+	return -1;
+}
+
+/*!
+ * \brief Setzt den aktiven Bereich einer Art
+ * \param scope Art (Scope) oder -1
+ * \param name Name des Bereichs ("" - keiner)
+ * \return Bisheriger Bereich, der beim Verlassen wieder gesetzt werden muss
+ *
+ * Nur Aufrufe aus dem GUI-Thread zählen; aus anderen Threads und ohne Watchdog passiert nichts.
+ */
+QString Watchdog::enter(int scope, const QString &name) {
+	Watchdog *watchdog = s_instance;
+	if (!watchdog || scope < 0 || QThread::currentThread() != watchdog->thread())
+		return QString();
+	QMutexLocker locker(&watchdog->a_mutex);
+	QString previous = watchdog->a_scopes[scope];
+	watchdog->a_scopes[scope] = name;
+	return previous;
+}
+
+/*!
+ * \brief Beschreibt einen Bereich für Log und Zähler
+ * \param scope Art
+ * \param name Name; Statements werden mit QueryStats::shape() von ihren Werten befreit
+ * \return Beschreibung
+ */
+QString Watchdog::m_describe(Scope scope, const QString &name) {
+	switch (scope) {
+	case Action:
+		return QString("Aktion %1").arg(name);
+	case Dialog:
+		return QString("Dialog %1").arg(name);
+	default:
+		return QString("Statement %1").arg(QueryStats::shape(name).left(200));
+	}
+}
+
+/*!
+ * \brief Herzschlag des GUI-Threads
+ */
+void Watchdog::beat() {
+	QMutexLocker locker(&a_mutex);
+	a_lastBeat = a_clock.nsecsElapsed();
+}
+
+/*!
+ * \brief Schleife des Watchdog-Threads
+ *
+ * Prüft alle a_interval Millisekunden den Herzschlag. Die Bereiche werden festgehalten, solange der
+ * GUI-Thread noch hängt; beim Ende des Hängers wären sie längst verlassen.
+ */
+void Watchdog::run() {
+	QMutexLocker locker(&a_mutex);
+	qint64 seen = a_lastBeat;
+	while (!a_stop) {
+		a_wake.wait(&a_mutex, a_interval);
+		if (a_stop)
+			break;
+		qint64 now = a_clock.nsecsElapsed();
+		if (a_stalled) {
+			if (a_lastBeat != seen) {
+				a_stalled = false;
+				m_stallEnded(seen + a_interval * qint64(1000000), a_lastBeat);
+				seen = a_lastBeat;
+			} else {
+				for (int i = 0; i < Scopes; ++i)
+					if (a_stallScopes[i].isEmpty())
+						a_stallScopes[i] = a_scopes[i];
+			}
+		} else if (now - a_lastBeat > a_threshold) {
+			a_stalled = true;
+			for (int i = 0; i < Scopes; ++i)
+				a_stallScopes[i] = a_scopes[i];
+		} else {
+			seen = a_lastBeat;
+		}
+	}
+}
+
+/*!
+ * \brief Zählt und protokolliert einen beendeten Hänger
+ * \param start Zeitpunkt, zu dem der nächste Herzschlag fällig gewesen wäre
+ * \param end Zeitpunkt des ersten Herzschlags danach
+ *
+ * Muss mit gesperrtem a_mutex aufgerufen werden.
+ */
+void Watchdog::m_stallEnded(qint64 start, qint64 end) {
+	qint64 duration = qMax(end - start, qint64(0));
+	++a_stalls;
+	a_stallTotal += duration;
+
+	QStringList scopes;
+	for (int i = 0; i < Scopes; ++i)
+		if (!a_stallScopes[i].isEmpty())
+			scopes << m_describe(Scope(i), a_stallScopes[i]);
+	if (scopes.isEmpty())
+		scopes << tr("außerhalb markierter Bereiche");
+	foreach (const QString &s, scopes) {
+		Counter &c = a_counters[s];
+		++c.count;
+		c.total += duration;
+		c.max = qMax(c.max, duration);
+	}
+
+	qint64 traceEnd = Tracer::now();
+	if (traceEnd >= 0) {
+		qint64 late = a_clock.nsecsElapsed() - end;
+		QVariantMap args;
+		args["scopes"] = scopes.join("; ");
+		Tracer::complete("watchdog", "GUI-Thread blockiert", traceEnd - late - duration, traceEnd - late, args);
+	}
+
+	if (!a_log.isOpen())
+		return;
+	QTextStream out(&a_log);
+	out.setCodec("UTF-8");
+	out << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz")
+	    << QString(" GUI-Thread hing %1 ms\n").arg(duration / 1e6, 0, 'f', 0);
+	foreach (const QString &s, scopes)
+		out << "  " << s << "\n";
+	out.flush();
+}
+
+/*!
+ * \brief Gibt die Anzahl aller Hänger an
+ */
+int Watchdog::stalls() const {
+	QMutexLocker locker(&a_mutex);
+	return a_stalls;
+}
+
+/*!
+ * \brief Gibt die Summe aller Hänger in Nanosekunden an
+ */
+qint64 Watchdog::stallTotal() const {
+	QMutexLocker locker(&a_mutex);
+	return a_stallTotal;
+}
+
+/*!
+ * \brief Gibt eine Kopie der Zähler zurück
+ * \return Zuordnung Bereich->Zähler
+ *
+ * Ein Hänger zählt für jeden Bereich, der währenddessen aktiv war, also z.B. für Aktion, Dialog und
+ * Statement zugleich.
+ */
+QHash<QString, Watchdog::Counter> Watchdog::counters() const {
+	QMutexLocker locker(&a_mutex);
+	return a_counters;
+}
@@ -0,0 +1,85 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QFile>
+
+/*!
+ * \brief Erkennt, wann der GUI-Thread hängt, und ordnet die Hänger den gerade aktiven Bereichen zu
+ *
+ * Ein Timer im GUI-Thread meldet alle a_interval Millisekunden einen Herzschlag. Der Watchdog-Thread prüft,
+ * wie lange der letzte zurückliegt; bleibt er länger als die Schwelle aus, merkt er sich, welche Aktion, welcher
+ * Dialog und welches Statement gerade aktiv waren (siehe enter()). Sobald die Ereignisschleife wieder läuft,
+ * wird der Hänger ins Log geschrieben und pro Bereich gezählt. Ohne Stacktraces, nur über die Bereiche, die
+ * TraceScope und TimedQuery ohnehin markieren.
+ */
+class Watchdog : public QThread {
+	Q_OBJECT
+public:
+	/*!
+	 * \brief Art eines Bereichs
+	 */
+	enum Scope {
+		Action,                          ///< Menüaktion (TraceScope mit Kategorie "action")
+		Dialog,                          ///< Dialog (TraceScope mit Kategorie "dialog")
+		Statement,                       ///< SQL-Statement (TimedQuery)
+		Scopes                           ///< Anzahl der Arten
+	};
+
+	/*!
+	 * \brief Zähler der Hänger eines Bereichs
+	 */
+	struct Counter {
+		int count;                       ///< Anzahl der Hänger
+		qint64 total;                    ///< Summe ihrer Dauer in Nanosekunden
+		qint64 max;                      ///< Längster Hänger in Nanosekunden
+
+		Counter() : count(0), total(0), max(0) {}
+	};
+
+private:
+	static Watchdog *s_instance;             ///< Die Instanz der Anwendung (0 - ausgeschaltet)
+	static constexpr int a_interval = 50;    ///< Abstand der Herzschläge in Millisekunden
+	QTimer a_heartbeat;                      ///< Löst im GUI-Thread die Herzschläge aus
+	QElapsedTimer a_clock;                   ///< Zeitbasis
+	qint64 a_threshold;                      ///< Schwelle in Nanosekunden
+	mutable QMutex a_mutex;                  ///< Schützt alle folgenden Attribute
+	QWaitCondition a_wake;                   ///< Weckt den Watchdog-Thread zum Beenden
+	bool a_stop;                             ///< Soll der Watchdog-Thread enden?
+	qint64 a_lastBeat;                       ///< Zeitpunkt des letzten Herzschlags
+	QString a_scopes[Scopes];                ///< Gerade aktive Bereiche im GUI-Thread
+	bool a_stalled;                          ///< Hängt der GUI-Thread gerade?
+	QString a_stallScopes[Scopes];           ///< Beim Erkennen des laufenden Hängers aktive Bereiche
+	int a_stalls;                            ///< Anzahl aller Hänger
+	qint64 a_stallTotal;                     ///< Summe aller Hänger in Nanosekunden
+	QHash<QString, Counter> a_counters;      ///< Zuordnung Bereich->Zähler
+	QFile a_log;                             ///< Log der Hänger
+
+	void m_stallEnded(qint64 start, qint64 end);
+	static QString m_describe(Scope scope, const QString &name);
+
+protected:
+	void run();
+
+public:
+	Watchdog(QString logFile, int thresholdMs, QObject *parent = 0);
+	~Watchdog();
+	static Watchdog *instance() {return s_instance;}
+	static int scope(const char *category);
+	static QString enter(int scope, const QString &name);
+
+	int thresholdMs() const {return int(a_threshold / 1000000);}
+	int stalls() const;
+	qint64 stallTotal() const;
+	QHash<QString, Counter> counters() const;
+
+private slots:
+	void beat();
+};
+
+#endif
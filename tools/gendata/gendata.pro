@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Generator für synthetische Testdaten
+#
+#-------------------------------------------------
+
+QT       += core sql
+QT       -= gui
+
+TARGET = gendata
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += main.cpp\
+    generator.cpp
+
+HEADERS  += \
+    generator.h
+
+CONFIG += c++11
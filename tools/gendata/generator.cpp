@@ -0,0 +1,410 @@
+#include "generator.h"
+#include <QSet>
+#include <QtMath>
+
+/*!
+ * \brief Konstruktor von Generator
+ * \param options Einstellungen
+ * \param sink Senke, die jedes Statement (ohne abschließendes Semikolon) ausführt oder schreibt
+ *
+ * Das laufende Schuljahr ist das des Stichtags options.today und beginnt wie in klasse_berechnen() im September.
+ */
+Generator::Generator(GeneratorOptions options, Sink sink) : a_options(options), a_sink(sink),
+	a_random(options.seed), a_teachers(0), a_ok(true) {
+	QDate today = a_options.today;
+	a_schoolYear = QDate(today.month() >= 9 ? today.year() : today.year() - 1, 9, 1);
+	a_yearSum = a_schoolYear.year() + 13;
+	a_options.lastGrade = qMax(a_options.lastGrade, a_options.firstGrade);
+	a_options.batch = qMax(a_options.batch, 1);
+}
+
+/*!
+ * \brief Gleichverteilte ganze Zahl
+ * \param n Obergrenze
+ * \return Zahl aus [0, n); 0 falls n = 0
+ */
+quint32 Generator::m_uniform(quint32 n) {
+	return n == 0 ? 0 : quint32(a_random()) % n;
+}
+
+/*!
+ * \brief Gleichverteilte reelle Zahl
+ * \return Zahl aus [0, 1)
+ */
+double Generator::m_real() {
+	return quint32(a_random()) / 4294967296.0;
+}
+
+/*!
+ * \brief Normalverteilte ganze Zahl (Box-Muller)
+ * \param mean Erwartungswert
+ * \param deviation Standardabweichung
+ * \return Gerundeter Wert
+ */
+int Generator::m_normal(double mean, double deviation) {
+	double u = 1.0 - m_real();
+	double v = m_real();
+	return qRound(mean + deviation * qSqrt(-2.0 * qLn(u)) * qCos(2.0 * M_PI * v));
+}
+
+/*!
+ * \brief Poisson-verteilte ganze Zahl
+ * \param mean Erwartungswert
+ * \return Wert >= 0
+ *
+ * Für kleine Erwartungswerte nach Knuth, für große über die Normalverteilung genähert.
+ */
+int Generator::m_poisson(double mean) {
+	if (mean <= 0)
+		return 0;
+	if (mean > 30)
+		return qMax(0, m_normal(mean, qSqrt(mean)));
+	double limit = qExp(-mean);
+	double p = m_real();
+	int k = 0;
+	while (p > limit) {
+		++k;
+		p *= m_real();
+	}
+	return k;
+}
+
+/*!
+ * \brief Zieht Elemente ohne Zurücklegen
+ * \param from Urne
+ * \param count Anzahl (höchstens from.size())
+ * \return Gezogene Elemente
+ */
+QVector<int> Generator::m_sample(const QVector<int> &from, int count) {
+	QVector<int> urn = from;
+	count = qBound(0, count, urn.size());
+	for (int i = 0; i < count; ++i)
+		std::swap(urn[i], urn[i + m_uniform(urn.size() - i)]);
+	urn.resize(count);
+	return urn;
+}
+
+/*!
+ * \brief Erzeugt einen Namen in der Form "Nachname Vorname" wie der ImportDialog
+ */
+QString Generator::m_name() {
+	static const char *lastNames[] = {"Müller", "Schmidt", "Schneider", "Fischer", "Weber", "Meyer", "Wagner",
+					  "Becker", "Schulz", "Hoffmann", "Schäfer", "Koch", "Bauer", "Richter", "Klein",
+					  "Wolf", "Schröder", "Neumann", "Schwarz", "Zimmermann", "Braun", "Krüger",
+					  "Hofmann", "Hartmann", "Lange", "Schmitt", "Werner", "Schmitz", "Krause",
+					  "Meier", "Lehmann", "Schmid", "Schulze", "Maier", "Köhler", "Herrmann",
+					  "König", "Walter", "Mayer", "Huber", "Kaiser", "Fuchs", "Peters", "Lang",
+					  "Scholz", "Möller", "Weiß", "Jung", "Hahn", "Schubert", "Yılmaz", "Kowalski",
+					  "Nguyen", "Popović", "O'Brien", "García"};
+	static const char *firstNames[] = {"Anna", "Lena", "Leonie", "Marie", "Sophie", "Emma", "Hannah", "Lea",
+					   "Mia", "Laura", "Lara", "Julia", "Sarah", "Lisa", "Johanna", "Clara",
+					   "Maximilian", "Alexander", "Paul", "Lukas", "Leon", "Felix", "Jonas", "Elias",
+					   "Tim", "Finn", "Noah", "Ben", "Luis", "Jan", "Niklas", "Jakob", "Moritz",
+					   "Emil", "Jürgen", "Zoë", "Ömer", "Ayşe"};
+	const int numLast = sizeof(lastNames) / sizeof(*lastNames);
+	const int numFirst = sizeof(firstNames) / sizeof(*firstNames);
+	QString last = QString::fromUtf8(lastNames[m_uniform(numLast)]);
+	QString first = QString::fromUtf8(firstNames[m_uniform(numFirst)]);
+	if (m_real() < 0.1)
+		last += "-" + QString::fromUtf8(lastNames[m_uniform(numLast)]);
+	return QString("%1 %2").arg(last).arg(first);
+}
+
+/*!
+ * \brief Bildet eine Buchstabenfolge wie bei Spalten einer Tabellenkalkulation
+ * \param index 0 - "a", 25 - "z", 26 - "aa", ...
+ *
+ * Wird für Klassenbuchstaben (bei sehr großen Jahrgängen mehrstellig) und Lehrerkürzel benutzt.
+ */
+QString Generator::m_letters(int index) {
+	QString letters;
+	for (++index; index > 0; index = (index - 1) / 26)
+		letters.prepend(QChar('a' + (index - 1) % 26));
+	return letters;
+}
+
+/*!
+ * \brief Zufälliges Datum innerhalb eines Schuljahres
+ * \param yearsAgo 0 - laufendes Schuljahr, 1 - Vorjahr, ...
+ * \return Datum, höchstens der Stichtag
+ */
+QDate Generator::m_date(int yearsAgo) {
+	QDate start = a_schoolYear.addYears(-yearsAgo);
+	int days = yearsAgo == 0 ? int(start.daysTo(a_options.today)) + 1 : 300;
+	return start.addDays(m_uniform(qMax(days, 1)));
+}
+
+/*!
+ * \brief Bildet eine gültige ISBN-13
+ * \param number Laufende Nummer des Titels
+ * \return ISBN mit Präfix 978-3 und korrekter Prüfziffer
+ */
+qlonglong Generator::m_isbn(qlonglong number) {
+	qlonglong body = 978300000000LL + number;
+	int sum = 0;
+	qlonglong rest = body;
+	for (int i = 0; i < 12; ++i, rest /= 10)
+		sum += int(rest % 10) * (i % 2 == 0 ? 3 : 1);
+	return body * 10 + (10 - sum % 10) % 10;
+}
+
+/*!
+ * \brief Setzt einen Text als MySQL-Stringliteral in Hochkommata
+ */
+QString Generator::m_quote(const QString &text) {
+	QString quoted = text;
+	quoted.replace('\\', "\\\\").replace('\'', "\\'");
+	return "'" + quoted + "'";
+}
+
+/*!
+ * \brief Beginnt ein mehrzeiliges INSERT
+ * \param insert Aufzufüllendes INSERT
+ * \param table Tabelle
+ * \param columns Spaltenliste mit Backticks
+ */
+void Generator::m_begin(Insert *insert, QString table, QString columns) {
+	insert->table = table;
+	insert->head = QString("INSERT INTO `%1` (%2) VALUES ").arg(table).arg(columns);
+	insert->values.clear();
+	insert->values.reserve(a_options.batch * 48);
+	insert->rows = 0;
+}
+
+/*!
+ * \brief Hängt eine Zeile an ein INSERT an und übergibt es, sobald a_options.batch Zeilen erreicht sind
+ * \param insert INSERT
+ * \param row Werte der Zeile ohne Klammern, bereits als SQL-Literale
+ */
+void Generator::m_add(Insert *insert, const QString &row) {
+	if (insert->rows > 0)
+		insert->values += ",";
+	insert->values += "(" + row + ")";
+	++insert->rows;
+	++a_counts[insert->table];
+	if (insert->rows >= a_options.batch)
+		m_flush(insert);
+}
+
+/*!
+ * \brief Übergibt die gesammelten Zeilen eines INSERTs an die Senke
+ */
+void Generator::m_flush(Insert *insert) {
+	if (insert->rows == 0)
+		return;
+	m_statement(insert->head + insert->values);
+	insert->values.clear();
+	insert->rows = 0;
+}
+
+/*!
+ * \brief Übergibt ein Statement an die Senke, solange diese noch keinen Fehler gemeldet hat
+ */
+void Generator::m_statement(const QString &sql) {
+	if (a_ok)
+		a_ok = a_sink(sql);
+}
+
+/*!
+ * \brief Erzeugt `buch` und `aliasse`
+ *
+ * Titel i gehört zur Jgst. firstGrade + i % (Anzahl der Jgst.). Die Titel enthalten keine Ziffern, damit die
+ * Suche der Listenansicht über `titel` LIKE '%7%' nur die Jgst. trifft.
+ */
+void Generator::m_books() {
+	static const char *series[] = {"Fokus", "Impulse", "Horizonte", "Kontexte", "Spektrum", "Schnittpunkt",
+				       "Green Line", "Découvertes", "Lambacher Schweizer", "Elemente", "Prisma",
+				       "Zeitreise", "Terra", "Natura", "Deutschbuch", "Campus"};
+	static const char *subjects[] = {"Deutsch", "Englisch", "Französisch", "Latein", "Mathematik", "Physik",
+					 "Chemie", "Biologie", "Geschichte", "Erdkunde", "Sozialkunde", "Religion",
+					 "Ethik", "Musik", "Kunst", "Informatik", "Wirtschaft"};
+	const int numSeries = sizeof(series) / sizeof(*series);
+	const int numSubjects = sizeof(subjects) / sizeof(*subjects);
+	int grades = a_options.lastGrade - a_options.firstGrade + 1;
+
+	a_isbns.resize(qMax(a_options.titles, grades));
+	a_gradeTitles = QVector<QVector<int>>(grades);
+	Insert books;
+	m_begin(&books, "buch", "`isbn`, `name`, `jgst`");
+	for (int i = 0; i < a_isbns.size(); ++i) {
+		int grade = a_options.firstGrade + i % grades;
+		a_isbns[i] = m_isbn(i);
+		a_gradeTitles[i % grades].append(i);
+		QString name = QString("%1 %2").arg(QString::fromUtf8(series[m_uniform(numSeries)]))
+				.arg(QString::fromUtf8(subjects[m_uniform(numSubjects)]));
+		m_add(&books, QString("%1,%2,'%3'").arg(a_isbns[i]).arg(m_quote(name)).arg(grade));
+	}
+	m_flush(&books);
+
+	Insert aliases;
+	m_begin(&aliases, "aliasse", "`alias`, `isbn`");
+	int alias = 0;
+	for (int i = 0; i < a_isbns.size(); ++i)
+		for (int n = m_poisson(a_options.aliasesPerTitle); n > 0; --n)
+			m_add(&aliases, QString("'b%1',%2").arg(++alias, 7, 10, QChar('0')).arg(a_isbns[i]));
+	m_flush(&aliases);
+}
+
+/*!
+ * \brief Teilt die Schüler auf Jahrgänge und Klassen auf und stellt die Bücherlisten zusammen
+ *
+ * Die Schüler werden gleichmäßig auf die Jahrgänge verteilt. Bis lastLetteredGrade entstehen Klassen mit
+ * normalverteilter Größe; ein Rest unter der halben Klassengröße wird der letzten Klasse zugeschlagen.
+ */
+void Generator::m_forms() {
+	int grades = a_options.lastGrade - a_options.firstGrade + 1;
+	int id = 1;
+	a_forms.clear();
+	for (int g = 0; g < grades; ++g) {
+		int grade = a_options.firstGrade + g;
+		int remaining = a_options.students / grades + (g < a_options.students % grades ? 1 : 0);
+		for (int letter = 0; remaining > 0; ++letter) {
+			Form form;
+			form.grade = grade;
+			if (grade <= a_options.lastLetteredGrade) {
+				form.letter = m_letters(letter);
+				form.size = qBound(1, m_normal(a_options.classSize, a_options.classSpread), remaining);
+				if (remaining - form.size < a_options.classSize / 2)
+					form.size = remaining;
+			} else {
+				form.size = remaining;
+			}
+			form.firstStudent = id;
+			form.books = m_sample(a_gradeTitles[g], a_options.booksPerGrade);
+			a_forms.append(form);
+			id += form.size;
+			remaining -= form.size;
+		}
+	}
+}
+
+/*!
+ * \brief Erzeugt `schueler`
+ */
+void Generator::m_students() {
+	Insert students;
+	m_begin(&students, "schueler", "`id`, `name`, `vajahr`, `kbuchst`");
+	foreach (const Form &form, a_forms) {
+		QString kbuchst = form.letter.isEmpty() ? QString("NULL") : m_quote(form.letter);
+		for (int i = 0; i < form.size; ++i)
+			m_add(&students, QString("%1,%2,%3,%4").arg(form.firstStudent + i).arg(m_quote(m_name()))
+			      .arg(a_yearSum - form.grade).arg(kbuchst));
+	}
+	m_flush(&students);
+}
+
+/*!
+ * \brief Erzeugt `lehrer`
+ */
+void Generator::m_teachers() {
+	a_teachers = qMax(1, a_options.students / qMax(a_options.studentsPerTeacher, 1));
+	Insert teachers;
+	m_begin(&teachers, "lehrer", "`id`, `name`, `kuerzel`");
+	for (int i = 0; i < a_teachers; ++i)
+		m_add(&teachers, QString("%1,%2,'%3'").arg(i + 1).arg(m_quote(m_name())).arg(m_letters(i)));
+	m_flush(&teachers);
+}
+
+/*!
+ * \brief Erzeugt `btausch`
+ *
+ * Die Bücher des laufenden Schuljahres werden in den ersten zwei Wochen ausgegeben. Für die Vorjahre wird pro
+ * Klasse die damalige Bücherliste neu gezogen; daraus bleibt der Anteil churn bei den Schülern liegen.
+ */
+void Generator::m_swaps() {
+	Insert swaps;
+	m_begin(&swaps, "btausch", "`sid`, `bid`, `datum`");
+	foreach (const Form &form, a_forms) {
+		int past = qMin(a_options.years, form.grade - a_options.firstGrade);
+		QVector<QVector<int>> lists(past + 1);
+		lists[0] = form.books;
+		for (int k = 1; k <= past; ++k)
+			lists[k] = m_sample(a_gradeTitles[form.grade - k - a_options.firstGrade], a_options.booksPerGrade);
+
+		for (int i = 0; i < form.size; ++i) {
+			int sid = form.firstStudent + i;
+			for (int k = 0; k <= past; ++k) {
+				QDate issued = a_schoolYear.addYears(-k);
+				foreach (int title, lists[k]) {
+					bool kept = k == 0 ? m_real() >= a_options.optOut : m_real() < a_options.churn;
+					if (kept)
+						m_add(&swaps, QString("%1,%2,'%3'").arg(sid).arg(a_isbns[title])
+						      .arg(issued.addDays(m_uniform(14)).toString(Qt::ISODate)));
+				}
+			}
+		}
+	}
+	m_flush(&swaps);
+}
+
+/*!
+ * \brief Erzeugt `sausleihe` und `lausleihe`
+ *
+ * Schüler leihen Titel ihrer aktuellen oder einer früheren Jgst., im Schnitt loanRate pro Jahr an der Schule.
+ * Lehrer leihen beliebige Titel, teils als Klassensatz (anz > 1).
+ */
+void Generator::m_loans() {
+	Insert loans;
+	m_begin(&loans, "sausleihe", "`sid`, `bid`, `anz`, `adatum`");
+	foreach (const Form &form, a_forms) {
+		int years = qMin(a_options.years, form.grade - a_options.firstGrade + 1);
+		for (int i = 0; i < form.size; ++i) {
+			QSet<int> titles;
+			for (int n = m_poisson(a_options.loanRate * years); n > 0; --n) {
+				int yearsAgo = m_uniform(years);
+				const QVector<int> &pool = a_gradeTitles[form.grade - yearsAgo - a_options.firstGrade];
+				int title = pool.value(m_uniform(pool.size()), -1);
+				if (title < 0 || titles.contains(title))
+					continue;
+				titles.insert(title);
+				m_add(&loans, QString("%1,%2,1,'%3'").arg(form.firstStudent + i).arg(a_isbns[title])
+				      .arg(m_date(yearsAgo).toString(Qt::ISODate)));
+			}
+		}
+	}
+	m_flush(&loans);
+
+	m_begin(&loans, "lausleihe", "`lid`, `bid`, `anz`, `adatum`");
+	for (int lid = 1; lid <= a_teachers; ++lid) {
+		QSet<int> titles;
+		for (int n = m_poisson(a_options.teacherLoans * a_options.years); n > 0; --n) {
+			int title = m_uniform(a_isbns.size());
+			if (titles.contains(title))
+				continue;
+			titles.insert(title);
+			int count = m_real() < 0.2 ? a_options.classSize + m_uniform(5) : 1;
+			m_add(&loans, QString("%1,%2,%3,'%4'").arg(lid).arg(a_isbns[title]).arg(count)
+			      .arg(m_date(m_uniform(qMax(a_options.years, 1))).toString(Qt::ISODate)));
+		}
+	}
+	m_flush(&loans);
+}
+
+/*!
+ * \brief Erzeugt den gesamten Datenbestand
+ * \param truncate true - vorher alle betroffenen Tabellen leeren
+ * \return true - die Senke hat alle Statements angenommen
+ *
+ * Während des Ladens sind die Prüfungen auf Eindeutigkeit und Fremdschlüssel ausgeschaltet und alles läuft in
+ * einer einzigen Transaktion; die Daten sind durch ihre Erzeugung ohnehin konsistent.
+ */
+bool Generator::run(bool truncate) {
+	a_ok = true;
+	a_counts.clear();
+	m_statement("SET @old_unique_checks = @@unique_checks, unique_checks = 0");
+	m_statement("SET @old_foreign_key_checks = @@foreign_key_checks, foreign_key_checks = 0");
+	if (truncate)
+		foreach (QString table, QStringList() << "btausch" << "sausleihe" << "lausleihe" << "aliasse"
+			 << "schueler" << "lehrer" << "buch")
+			m_statement(QString("TRUNCATE TABLE `%1`").arg(table));
+	m_statement("START TRANSACTION");
+	m_books();
+	m_forms();
+	m_students();
+	m_teachers();
+	m_swaps();
+	m_loans();
+	m_statement("COMMIT");
+	m_statement("SET unique_checks = @old_unique_checks, foreign_key_checks = @old_foreign_key_checks");
+	return a_ok;
+}
@@ -0,0 +1,126 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDate>
+#include <QMap>
+#include <functional>
+#include <random>
+
+/*!
+ * \brief Einstellungen des Generators
+ *
+ * Die Vorgaben ergeben eine große Schule mit etwa 10000 Schülern und gut 100000 Zeilen Ausleihhistorie.
+ */
+struct GeneratorOptions {
+	quint32 seed;                            ///< Startwert des Zufallsgenerators
+	int students;                            ///< Anzahl der Schüler
+	int firstGrade;                          ///< Unterste Jahrgangsstufe
+	int lastGrade;                           ///< Oberste Jahrgangsstufe
+	int lastLetteredGrade;                   ///< Letzte Jgst. mit Klassenbuchstaben (darüber nur Kurse)
+	int classSize;                           ///< Mittlere Klassengröße
+	int classSpread;                         ///< Standardabweichung der Klassengröße
+	int titles;                              ///< Anzahl der Buchtitel
+	double aliasesPerTitle;                  ///< Mittlere Anzahl der Aliasse pro Titel
+	int booksPerGrade;                       ///< Bücher pro Schüler und Jgst. im Büchertausch
+	double optOut;                           ///< Anteil der Bücher der Bücherliste, die ein Schüler nicht nimmt
+	int years;                               ///< Jahre der Historie
+	double churn;                            ///< Anteil der Bücher eines Vorjahres, die nicht zurückgegeben wurden
+	double loanRate;                         ///< Mittlere Anzahl zusätzlicher Ausleihen pro Schüler und Jahr
+	int studentsPerTeacher;                  ///< Schüler pro Lehrer
+	double teacherLoans;                     ///< Mittlere Anzahl der Ausleihen pro Lehrer und Jahr
+	int batch;                               ///< Zeilen pro INSERT-Statement
+	QDate today;                             ///< Stichtag, auf den sich Klassen und Ausleihdaten beziehen
+
+	GeneratorOptions() : seed(1), students(10000), firstGrade(5), lastGrade(12), lastLetteredGrade(10),
+		classSize(28), classSpread(3), titles(2000), aliasesPerTitle(1.5), booksPerGrade(12), optOut(0.05),
+		years(5), churn(0.03), loanRate(0.5), studentsPerTeacher(12), teacherLoans(6), batch(1000),
+		today(2025, 10, 1) {}
+};
+
+/*!
+ * \brief Erzeugt einen synthetischen Datenbestand passend zu buecher.sql
+ *
+ * Die Daten werden als mehrzeilige INSERT-Statements an eine Senke übergeben, Tabelle für Tabelle in der
+ * Reihenfolge der Fremdschlüssel. Bei gleichen Einstellungen, gleichem Startwert und gleichem Stichtag entstehen
+ * auf jeder Plattform und an jedem Tag dieselben Statements; deshalb werden nur der Mersenne-Twister selbst und
+ * eigene, einfache Verteilungen benutzt, nicht die der Standardbibliothek.
+ *
+ * Das Modell der Schule:
+ * - Die Titel sind gleichmäßig auf die Jahrgangsstufen verteilt. Jede Klasse hat eine Bücherliste aus
+ *   booksPerGrade Titeln ihrer Jgst.; davon erhält jeder Schüler im aktuellen Schuljahr alle bis auf
+ *   den Anteil optOut (`btausch`).
+ * - Aus jedem der letzten years Schuljahre, die der Schüler schon an der Schule war, ist der Anteil churn der
+ *   damaligen Bücher nicht zurückgegeben worden und steht mit dem alten Datum noch in `btausch`.
+ * - Zusätzliche Ausleihen (`sausleihe`, `lausleihe`) sind über die years Jahre verteilt.
+ */
+class Generator {
+public:
+	typedef std::function<bool(const QString &)> Sink;   ///< Nimmt ein Statement entgegen; false bricht ab
+
+private:
+	/*!
+	 * \brief Sammelt Zeilen zu einem mehrzeiligen INSERT
+	 */
+	struct Insert {
+		QString table;                   ///< Name der Tabelle
+		QString head;                    ///< "INSERT INTO `tabelle` (...) VALUES "
+		QString values;                  ///< Bisher gesammelte Zeilen
+		int rows;                        ///< Anzahl der gesammelten Zeilen
+	};
+
+	/*!
+	 * \brief Eine Klasse (oder in der Oberstufe der ganze Jahrgang)
+	 */
+	struct Form {
+		int grade;                       ///< Jahrgangsstufe
+		QString letter;                  ///< Klassenbuchstabe ("" in der Oberstufe)
+		int firstStudent;                ///< Id des ersten Schülers
+		int size;                        ///< Anzahl der Schüler
+		QVector<int> books;              ///< Bücherliste der Klasse (Index in a_isbns)
+	};
+
+	GeneratorOptions a_options;              ///< Einstellungen
+	Sink a_sink;                             ///< Senke für die Statements
+	std::mt19937 a_random;                   ///< Zufallsgenerator
+	QDate a_schoolYear;                      ///< Beginn des laufenden Schuljahres
+	int a_yearSum;                           ///< Jgst. + Abschlussjahr im laufenden Schuljahr
+	QVector<qlonglong> a_isbns;              ///< Zuordnung Titel->ISBN
+	QVector<QVector<int>> a_gradeTitles;     ///< Zuordnung Jgst. (ab firstGrade)->Titel
+	QVector<Form> a_forms;                   ///< Alle Klassen
+	int a_teachers;                          ///< Anzahl der Lehrer
+	QMap<QString, qlonglong> a_counts;       ///< Zuordnung Tabelle->Anzahl der erzeugten Zeilen
+	bool a_ok;                               ///< Hat die Senke bisher alles angenommen?
+
+	quint32 m_uniform(quint32 n);
+	double m_real();
+	int m_normal(double mean, double deviation);
+	int m_poisson(double mean);
+	QVector<int> m_sample(const QVector<int> &from, int count);
+	QString m_name();
+	static QString m_letters(int index);
+	QDate m_date(int yearsAgo);
+	static qlonglong m_isbn(qlonglong number);
+	static QString m_quote(const QString &text);
+
+	void m_begin(Insert *insert, QString table, QString columns);
+	void m_add(Insert *insert, const QString &row);
+	void m_flush(Insert *insert);
+	void m_statement(const QString &sql);
+
+	void m_books();
+	void m_forms();
+	void m_students();
+	void m_teachers();
+	void m_swaps();
+	void m_loans();
+
+public:
+	Generator(GeneratorOptions options, Sink sink);
+	bool run(bool truncate);
+	QMap<QString, qlonglong> counts() const {return a_counts;}
+};
+
+#endif
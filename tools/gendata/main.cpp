@@ -0,0 +1,153 @@
+#include "generator.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QTextCodec>
+#include <QtSql>
+#include <cstdio>
+
+/*!
+ * \brief Hauptprogramm des Datengenerators
+ * \param argc Anzahl der Argumente
+ * \param argv Argumente in Form eines char **
+ * \return 0 im Falle eines Erfolgs
+ *
+ * Ohne --output werden die Daten direkt in die Datenbank geladen. Die Verbindung wird wie von Obsidian aus den
+ * Einstellungen (db/...) gelesen und kann mit --host, --port, --database, --user und --password überschrieben
+ * werden. Mit --output wird stattdessen ein SQL-Skript geschrieben ("-" für die Standardausgabe), das sich mit
+ * `mysql biblio < datei.sql` laden lässt.
+ */
+int main(int argc, char *argv[])
+{
+	QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("Obsidian");
+	QCoreApplication::setOrganizationName("Philip Schlösser");
+	QCoreApplication::setOrganizationDomain("https://github.com/philip98/");
+
+	GeneratorOptions o;
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Erzeugt einen synthetischen Datenbestand für Obsidian (passend zu buecher.sql).");
+	parser.addHelpOption();
+	QCommandLineOption output(QStringList() << "o" << "output", "Schreibt ein SQL-Skript nach <datei> statt in die Datenbank.", "datei");
+	QCommandLineOption truncate("truncate", "Leert vorher buch, aliasse, schueler, lehrer und alle Ausleihen.");
+	QCommandLineOption host("host", "Datenbankserver.", "host");
+	QCommandLineOption port("port", "Port des Datenbankservers.", "port");
+	QCommandLineOption database("database", "Name der Datenbank.", "name");
+	QCommandLineOption user("user", "Benutzername.", "name");
+	QCommandLineOption password("password", "Passwort.", "passwort");
+	QCommandLineOption seed("seed", "Startwert des Zufallsgenerators.", "zahl", QString::number(o.seed));
+	QCommandLineOption students("students", "Anzahl der Schüler.", "anzahl", QString::number(o.students));
+	QCommandLineOption grades("grades", "Jahrgangsstufen als <erste>-<letzte>.", "von-bis",
+				  QString("%1-%2").arg(o.firstGrade).arg(o.lastGrade));
+	QCommandLineOption lettered("lettered", "Letzte Jgst. mit Klassenbuchstaben.", "jgst", QString::number(o.lastLetteredGrade));
+	QCommandLineOption classSize("class-size", "Mittlere Klassengröße.", "anzahl", QString::number(o.classSize));
+	QCommandLineOption classSpread("class-spread", "Standardabweichung der Klassengröße.", "anzahl", QString::number(o.classSpread));
+	QCommandLineOption titles("titles", "Anzahl der Buchtitel.", "anzahl", QString::number(o.titles));
+	QCommandLineOption aliases("aliases", "Mittlere Anzahl der Aliasse pro Titel.", "anzahl", QString::number(o.aliasesPerTitle));
+	QCommandLineOption books("books-per-grade", "Bücher pro Schüler und Jgst. im Büchertausch.", "anzahl",
+				 QString::number(o.booksPerGrade));
+	QCommandLineOption optOut("opt-out", "Anteil der Bücherliste, den ein Schüler nicht nimmt.", "anteil", QString::number(o.optOut));
+	QCommandLineOption years("years", "Jahre der Ausleihhistorie.", "anzahl", QString::number(o.years));
+	QCommandLineOption churn("churn", "Anteil der Bücher eines Vorjahres, die nicht zurückgegeben wurden.", "anteil",
+				 QString::number(o.churn));
+	QCommandLineOption loans("loans", "Zusätzliche Ausleihen pro Schüler und Jahr.", "anzahl", QString::number(o.loanRate));
+	QCommandLineOption teachers("students-per-teacher", "Schüler pro Lehrer.", "anzahl", QString::number(o.studentsPerTeacher));
+	QCommandLineOption teacherLoans("teacher-loans", "Ausleihen pro Lehrer und Jahr.", "anzahl", QString::number(o.teacherLoans));
+	QCommandLineOption today("today", "Stichtag für Klassen und Ausleihdaten (JJJJ-MM-TT oder \"heute\").", "datum",
+				 o.today.toString(Qt::ISODate));
+	QCommandLineOption batch("batch", "Zeilen pro INSERT-Statement.", "anzahl", QString::number(o.batch));
+	parser.addOptions(QList<QCommandLineOption>() << output << truncate << host << port << database << user << password
+			  << seed << students << grades << lettered << classSize << classSpread << titles << aliases << books
+			  << optOut << years << churn << loans << teachers << teacherLoans << today << batch);
+	parser.process(a);
+
+	o.seed = parser.value(seed).toUInt();
+	o.students = parser.value(students).toInt();
+	o.firstGrade = parser.value(grades).section('-', 0, 0).toInt();
+	o.lastGrade = parser.value(grades).section('-', 1, 1).toInt();
+	o.lastLetteredGrade = parser.value(lettered).toInt();
+	o.classSize = qMax(1, parser.value(classSize).toInt());
+	o.classSpread = parser.value(classSpread).toInt();
+	o.titles = parser.value(titles).toInt();
+	o.aliasesPerTitle = parser.value(aliases).toDouble();
+	o.booksPerGrade = parser.value(books).toInt();
+	o.optOut = parser.value(optOut).toDouble();
+	o.years = parser.value(years).toInt();
+	o.churn = parser.value(churn).toDouble();
+	o.loanRate = parser.value(loans).toDouble();
+	o.studentsPerTeacher = parser.value(teachers).toInt();
+	o.teacherLoans = parser.value(teacherLoans).toDouble();
+	o.batch = parser.value(batch).toInt();
+	o.today = parser.value(today) == "heute" ? QDate::currentDate() : QDate::fromString(parser.value(today), Qt::ISODate);
+	if (o.students <= 0 || o.firstGrade <= 0 || o.lastGrade < o.firstGrade) {
+		fprintf(stderr, "Ungültige Anzahl von Schülern oder Jahrgangsstufen\n");
+		return 1;
+	}
+	if (!o.today.isValid()) {
+		fprintf(stderr, "Ungültiger Stichtag %s\n", qPrintable(parser.value(today)));
+		return 1;
+	}
+
+	QFile file;
+	QTextStream out(&file);
+	out.setCodec("UTF-8");
+	QSqlDatabase db;
+	Generator::Sink sink;
+	if (parser.isSet(output)) {
+		bool opened;
+		if (parser.value(output) == "-") {
+			opened = file.open(stdout, QIODevice::WriteOnly);
+		} else {
+			file.setFileName(parser.value(output));
+			opened = file.open(QIODevice::WriteOnly);
+		}
+		if (!opened) {
+			fprintf(stderr, "%s kann nicht geschrieben werden\n", qPrintable(parser.value(output)));
+			return 1;
+		}
+		out << "-- Obsidian-Testdaten, erzeugt mit gendata " << QCoreApplication::arguments().mid(1).join(' ') << "\n";
+		sink = [&out](const QString &sql) -> bool {
+			out << sql << ";\n";
+			return out.status() == QTextStream::Ok;
+		};
+	} else {
+		QSettings settings;
+		db = QSqlDatabase::addDatabase("QMYSQL");
+		db.setHostName(parser.isSet(host) ? parser.value(host) : settings.value("db/ip", "127.0.0.1").toString());
+		db.setPort(parser.isSet(port) ? parser.value(port).toInt() : settings.value("db/port", 3306).toInt());
+		db.setDatabaseName(parser.isSet(database) ? parser.value(database) : settings.value("db/name", "biblio").toString());
+		db.setUserName(parser.isSet(user) ? parser.value(user) : settings.value("db/usr").toString());
+		db.setPassword(parser.isSet(password) ? parser.value(password) : settings.value("db/pwd").toString());
+		if (!db.open()) {
+			fprintf(stderr, "%s\n", qPrintable(db.lastError().text()));
+			return 1;
+		}
+		sink = [&db](const QString &sql) -> bool {
+			QSqlQuery q(db);
+			if (q.exec(sql))
+				return true;
+			fprintf(stderr, "%s\n%s\n", qPrintable(q.lastError().text()), qPrintable(sql.left(200)));
+			return false;
+		};
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	Generator generator(o, sink);
+	bool ok = generator.run(parser.isSet(truncate));
+	out.flush();
+
+	qlonglong total = 0;
+	QMap<QString, qlonglong> counts = generator.counts();
+	for (QMap<QString, qlonglong>::const_iterator i = counts.constBegin(); i != counts.constEnd(); ++i) {
+		fprintf(stderr, "%-10s %10lld\n", qPrintable(i.key()), i.value());
+		total += i.value();
+	}
+	fprintf(stderr, "%-10s %10lld Zeilen in %.1f s%s\n", "gesamt", total, timer.elapsed() / 1000.0,
+		ok ? "" : " (abgebrochen)");
+	return ok ? 0 : 1;
+}